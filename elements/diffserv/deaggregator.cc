@@ -61,11 +61,119 @@ int
 DeAggregator::configure(Vector<String>& conf, ErrorHandler* errh) 
 {
   _et=0x0642;
+  _clone=false;
   return cp_va_kparse(conf, this, errh,
 			"ETHTYPE", 0, cpUnsignedShort, &_et,
+			"CLONE", 0, cpBool, &_clone,
 			cpEnd);
 }
 
+Packet *
+DeAggregator::copy_subframe(const uint8_t *eh, const uint8_t *sub, uint16_t len)
+{
+  WritablePacket *wp = _p->clone()->uniqueify();
+  wp = wp->put(len);
+  if (!wp) {
+    return 0;
+  }
+  memcpy(wp->data(), eh, 12);
+  memcpy(wp->data()+12, sub+2, 2);
+  memcpy(wp->data()+14, sub+4, len);
+  wp->set_mac_header(wp->data(), 14);
+  return wp;
+}
+
+void
+DeAggregator::push_clones(Packet *p)
+{
+  // the aggregate is not shared, so its buffer can be written until the
+  // first clone is taken
+  WritablePacket *wp = p->uniqueify();
+  uint8_t eh[12];
+  memcpy(eh, wp->data(), 12);
+
+  _subframes.clear();
+  uint32_t bytes[2] = { 0, 0 };
+  uint32_t np = 14;
+  while (np + 4 <= wp->length()) {
+    uint16_t npl;
+    memcpy(&npl, wp->data()+np, 2);
+    npl = ntohs(npl);
+    if (np + 4 + npl > wp->length()) {
+      break;
+    }
+    Subframe s;
+    s._offset = np;
+    s._length = npl;
+    s._copy = 0;
+    s._cloned = false;
+    bytes[_subframes.size() % 2] += npl;
+    _subframes.push_back(s);
+    np += npl + 4;
+  }
+
+  // the header of a cloned subframe is written over the 10 bytes before
+  // its length field, so it must not land on another cloned subframe:
+  // clone every other subframe, choosing the parity that saves the most
+  // bytes, unless the subframe before it is shorter than 6 bytes; then
+  // also clone any other subframe no cloned header lands on
+  int n = _subframes.size();
+  int parity = (bytes[1] > bytes[0]) ? 1 : 0;
+  uint32_t limit = 0;
+  for (int i = parity; i < n; i += 2) {
+    Subframe &s = _subframes[i];
+    if (s._offset - 10 >= limit) {
+      s._cloned = true;
+      limit = s._offset + 4 + s._length;
+    }
+  }
+  limit = 0;
+  for (int i = 0; i < n; i++) {
+    Subframe &s = _subframes[i];
+    if (!s._cloned && s._offset - 10 >= limit) {
+      int k = i + 1;
+      while (k < n && !_subframes[k]._cloned) {
+        k++;
+      }
+      if (k == n || _subframes[k]._offset - 10 >= s._offset + 4 + s._length) {
+        s._cloned = true;
+      }
+    }
+    if (s._cloned) {
+      limit = s._offset + 4 + s._length;
+    }
+  }
+
+  // copies are taken before any header is rewritten
+  for (int i = 0; i < n; i++) {
+    if (!_subframes[i]._cloned) {
+      _subframes[i]._copy = copy_subframe(eh, wp->data() + _subframes[i]._offset, _subframes[i]._length);
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    if (_subframes[i]._cloned) {
+      // the ethertype is already in place right before the payload
+      memcpy(wp->data() + _subframes[i]._offset - 10, eh, 12);
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    Packet *q = _subframes[i]._copy;
+    if (_subframes[i]._cloned) {
+      q = wp->clone();
+      if (q) {
+        q->pull(_subframes[i]._offset - 10);
+        q->take(q->length() - 14 - _subframes[i]._length);
+        q->set_mac_header(q->data(), 14);
+      }
+    }
+    if (q) {
+      output(0).push(q);
+    }
+  }
+  wp->kill();
+}
+
 void
 DeAggregator::push(int, Packet *p)
 {
@@ -79,20 +187,18 @@ DeAggregator::push(int, Packet *p)
 	p->kill();
 	return;
   }
+  if (_clone && !p->shared()) {
+    push_clones(p);
+    return;
+  }
   uint16_t np = 14;
   uint16_t npl = 0;
   while (np < p->length()) {
     memcpy(&npl, p->data()+np, 2);
-    WritablePacket *wp = _p->clone()->uniqueify();
-    wp = wp->put(ntohs(npl));
-    EtherAddress dst = EtherAddress(p->ether_header()->ether_dhost);
-    EtherAddress src = EtherAddress(p->ether_header()->ether_shost);
-    memcpy(wp->data(), dst.data(), 6);
-    memcpy(wp->data()+6, src.data(), 6);
-    memcpy(wp->data()+12, p->data()+np+2,2);
-    memcpy(wp->data()+14, p->data()+np+4,ntohs(npl));
+    if (Packet *q = copy_subframe(p->data(), p->data()+np, ntohs(npl))) {
+      output(0).push(q);
+    }
     np += ntohs(npl)+4;
-    output(0).push(wp);
   }
   p->kill();
 }
@@ -1,17 +1,26 @@
 #ifndef CLICK_DEAGGREGATOR_HH
 #define CLICK_DEAGGREGATOR_HH
 #include <click/element.hh>
+#include <click/vector.hh>
 CLICK_DECLS
 
 /*
  * =c
- * DeAggregator()
+ * DeAggregator([ETHTYPE, CLONE])
  * =s ethernet
  * splits incoming packets
  * =io
  * one output, one input
  * =d
  * Expects aggregated packets as input. Splits incoming packets.
+ *
+ * If CLONE is true, subframes are emitted as clones of the aggregate
+ * whenever the aggregate is not shared. The ethernet header of a cloned
+ * subframe is rewritten over the bytes preceding its payload, which
+ * belong to the previous subframe; so clones alternate with copies,
+ * choosing the parity that saves the most bytes. A subframe that follows
+ * one shorter than 6 bytes is copied, since its header would reach into
+ * the subframe before that. Default is false.
  */
 
 class DeAggregator : public Element { public:
@@ -30,8 +39,20 @@ class DeAggregator : public Element { public:
 
 private:
 
+  struct Subframe {
+    uint32_t _offset;
+    uint16_t _length;
+    Packet *_copy;
+    bool _cloned;
+  };
+
   Packet *_p;
   uint16_t _et;     // This protocol's ethertype
+  bool _clone;
+  Vector<Subframe> _subframes;
+
+  Packet *copy_subframe(const uint8_t *, const uint8_t *, uint16_t);
+  void push_clones(Packet *);
 
 };
 
@@ -65,8 +65,9 @@ FairBuffer::FairBuffer() :
   _task(this), _timer(&_task)
 {
   _fair_table = new FairTable();
-  _head_table = new HeadTable();
   _queue_pool = new QueuePool();
+  _active = 0;
+  _ntrash = 0;
   reset();
 }
 
@@ -76,24 +77,15 @@ FairBuffer::~FairBuffer()
   // de-allocate fair-table
   TableItr itr = _fair_table->begin();
   while(itr != _fair_table->end()){
+    if(itr.value()->_pending){
+      itr.value()->_pending->kill();
+    }
     release_queue(itr.value());
     itr++;
   } // end while
   _fair_table->clear();
   delete _fair_table;
 
-  // de-allocate head-table
-  HeadItr itr_head = _head_table->begin();
-  while(itr_head != _head_table->end()) {
-    Packet* p = itr_head.value();
-    if(p){
-      p->kill();
-    }
-    itr_head++;
-  } // end while
-  _head_table->clear();
-  delete _head_table;
-
   // de-allocate pool
   PoolItr itr_pool = _queue_pool->begin();
   while(itr_pool != _queue_pool->end()){
@@ -114,14 +106,20 @@ FairBuffer::~FairBuffer()
 }
 
 uint32_t 
-FairBuffer::compute_deficit(Packet* p)
+FairBuffer::compute_deficit(FairBufferQueue* q, Packet* p)
 {
   if (!p)
     return 0;
   if (!_lt || !_arp_table)
     return p->length();
-  IPAddress to = _arp_table->reverse_lookup(_next);
-  return _lt->get_host_metric_from_me(to);
+  // metrics only change when the link table recomputes its routes, a
+  // destination with no metric yet is looked up again every time
+  if (!q->_metric || q->_metric_epoch != _lt->route_epoch()) {
+    IPAddress to = _arp_table->reverse_lookup(q->_dst);
+    q->_metric = _lt->get_host_metric_from_me(to);
+    q->_metric_epoch = _lt->route_epoch();
+  }
+  return q->_metric;
 }
 
 void *
@@ -143,11 +141,6 @@ FairBuffer::reset()
   _creates=0;
   _deletes=0;
   _sleepiness=0;
-
-  if(!_fair_table->empty()) 
-    _next = _fair_table->begin().key();
-  else
-    _next = EtherAddress();
 }
 
 int 
@@ -192,6 +185,10 @@ void
 FairBuffer::push(int, Packet* p)
 { 
 
+  if (_ntrash.value()) {
+    collect_trash();
+  }
+
   click_ether *e = (click_ether *)p->data();
   EtherAddress dhost = EtherAddress(e->ether_dhost);
 
@@ -202,12 +199,8 @@ FairBuffer::push(int, Packet* p)
   if(!q){
     // this also resets the deficit counter
     q = request_queue();
-    if(_fair_table->empty()) {
-      _next = dhost;
-      _empty_note.wake();
-     }
+    q->_dst = dhost;
     _fair_table->set(dhost, q);  
-    _head_table->set(dhost, 0);  
   } // end if 
 
   if (!p->timestamp_anno()) {
@@ -215,8 +208,16 @@ FairBuffer::push(int, Packet* p)
   }  
   p->timestamp_anno() += Timestamp::make_msec(_max_delay);
 
-  // push packet on queue or fail
+  // push packet on queue or fail, an idle queue rejoins the active ring
+  // once it holds the packet (see pull())
   if(q->push(p)){
+    if (q->_idle.value()) {
+      _ring_lock.acquire();
+      if (q->_idle.value()) {
+        link_queue(q);
+      }
+      _ring_lock.release();
+    }
     _empty_note.wake();
   } else {
     // queue overflow, destroy the packet
@@ -241,7 +242,7 @@ Packet *
 FairBuffer::pull(int)
 {
 
-    if (_fair_table->empty()) {
+    if (!_active) {
         if (++_sleepiness == SLEEPINESS_TRIGGER) {
           _empty_note.sleep();
         }
@@ -251,15 +252,12 @@ FairBuffer::pull(int)
     bool trash = false;
     bool send = false;
 
-    TableItr active = _fair_table->find(_next);
-    HeadItr head = _head_table->find(_next);
-
-    FairBufferQueue* queue = active.value();
+    FairBufferQueue* queue = _active;
 
     Packet *p = 0;
-    if (head.value()) {
-      p = head.value();
-      _head_table->set(_next, 0);
+    if (queue->_pending) {
+      p = queue->_pending;
+      queue->_pending = 0;
     } else if (queue->ready()) {
       p = queue->aggregate();
     } 
@@ -269,30 +267,43 @@ FairBuffer::pull(int)
       if ((queue->_size == 0) && (++queue->_trash == TRASH_TRIGGER)) {
           trash = true;
       }
-    } else if (!scheduler_active() || (compute_deficit(p) <= queue->_deficit)) {
-      queue->_deficit -= compute_deficit(p);
+    } else if (!scheduler_active()) {
       send = true;
     } else {
-      queue->_trash = 0;
-      _head_table->set(_next, p);
+      uint32_t deficit = compute_deficit(queue, p);
+      if (deficit <= queue->_deficit) {
+        queue->_deficit -= deficit;
+        send = true;
+      } else {
+        queue->_trash = 0;
+        queue->_pending = p;
+      }
     }
 
     if (trash) {
-        release_queue(queue);
-        active = _fair_table->erase(active);
-        _head_table->erase(head);
+        // the queue only leaves the ring if push() did not refill it
+        // after it was flagged idle; push() checks the flag after
+        // filling the queue, so one of the two sides sees the other
+        _ring_lock.acquire();
+        queue->_idle.swap(1);
+        if (queue->_size == 0) {
+          unlink_queue(queue);
+          if (!queue->_trashed) {
+            queue->_trashed = true;
+            _trash_list.push_back(queue);
+            _ntrash = _trash_list.size();
+          }
+        } else {
+          queue->_idle = 0;
+          _active = queue->_next;
+        }
+        _ring_lock.release();
     } else {
-       active++;
+        _active = queue->_next;
     }
 
-    if (!_fair_table->empty()) {
-      if (active == _fair_table->end()) {
-        active = _fair_table->begin();
-      }
-      active.value()->_deficit += _quantum;
-      _next = active.key();
-    } else {
-      _next = EtherAddress();
+    if (_active) {
+      _active->_deficit += _quantum;
     }
 
     return (send) ? p : 0;
@@ -306,15 +317,79 @@ FairBuffer::list_queues()
   TableItr itr = _fair_table->begin();
   result << "Key,Capacity,Packets,Bytes\n";
   while(itr != _fair_table->end()){
-    result << (itr.key()).unparse() << ","
-	   << itr.value()->_capacity << "," 
-	   << itr.value()->_size << "," 
-	   << itr.value()->_bsize << "\n";
+    if (!itr.value()->_idle.value()) {
+      result << (itr.key()).unparse() << ","
+	     << itr.value()->_capacity << "," 
+	     << itr.value()->_size.value() << "," 
+	     << itr.value()->_bsize.value() << "\n";
+    }
     itr++;
   } // end while
   return(result.take_string());
 }
 
+void
+FairBuffer::link_queue(FairBufferQueue* q)
+{
+  // pull() advances _active without the lock, so splice relative to a
+  // single snapshot of it
+  FairBufferQueue* active = _active;
+  q->_deficit = 0;
+  q->_trash = 0;
+  if(!active) {
+    q->_next = q;
+    q->_prev = q;
+  } else {
+    // join the ring right behind the queue being served
+    q->_next = active;
+    q->_prev = active->_prev;
+  }
+  q->_idle = 0;
+  // q must be complete before pull() can reach it
+  click_fence();
+  if(!active) {
+    _active = q;
+  } else {
+    q->_prev->_next = q;
+    active->_prev = q;
+  }
+}
+
+void
+FairBuffer::unlink_queue(FairBufferQueue* q)
+{
+  if (q->_next == q) {
+    _active = 0;
+  } else {
+    q->_prev->_next = q->_next;
+    q->_next->_prev = q->_prev;
+    _active = q->_next;
+  }
+  q->_next = 0;
+  q->_prev = 0;
+}
+
+void
+FairBuffer::collect_trash()
+{
+  // only push() touches the destination table, so the idle queues pull()
+  // unlinked are erased and recycled here; a queue push() refilled and
+  // relinked in the meantime stays
+  _ring_lock.acquire();
+  for (PoolItr itr = _trash_list.begin(); itr != _trash_list.end(); itr++) {
+    FairBufferQueue* q = *itr;
+    q->_trashed = false;
+    if (q->_idle.value() && q->_size == 0) {
+      _fair_table->erase(q->_dst);
+      release_queue(q);
+      _deletes++;
+    }
+  }
+  _trash_list.clear();
+  _ntrash = 0;
+  _ring_lock.release();
+}
+
 FairBufferQueue * 
 FairBuffer::request_queue() 
 {
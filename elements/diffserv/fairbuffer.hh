@@ -7,6 +7,7 @@
 #include <clicknet/ether.h>
 #include <click/task.hh>
 #include <click/timer.hh>
+#include <click/atomic.hh>
 #include <elements/standard/simplequeue.hh>
 CLICK_DECLS
 
@@ -30,6 +31,11 @@ CLICK_DECLS
  * respectively 60 and 1500 bytes. Is LT is specified MIN_BURST is dynamically 
  * compute according with the link's mmetric. Aggregation buffers are polled 
  * according with a Deficit Round Robin (DRR) policy.
+ *
+ * Multithreaded Click note: like SimpleQueue, FairBuffer is designed for one 
+ * pushing and one pulling thread. Per-destination queues are lock-free 
+ * single-producer/single-consumer rings; a lock is only taken when a queue 
+ * joins or leaves the set of active queues.
  */
 
 class FairBufferQueue;
@@ -83,28 +89,32 @@ class FairBuffer : public SimpleQueue { public:
     typedef HashTable<EtherAddress, FairBufferQueue*> FairTable;
     typedef FairTable::iterator TableItr;
 
-    typedef HashTable<EtherAddress, Packet*> HeadTable;
-    typedef HeadTable::iterator HeadItr;
-
     typedef Vector<FairBufferQueue*> QueuePool;
     typedef QueuePool::iterator PoolItr;
 
     FairTable* _fair_table;
-    HeadTable* _head_table;
     QueuePool* _queue_pool;
 
-    EtherAddress _next;
+    // ring of active queues, pull() serves the one at _active; queues
+    // join and leave it under _ring_lock
+    FairBufferQueue* volatile _active;
+    Spinlock _ring_lock;
+    // idle queues pull() unlinked, push() frees them; under _ring_lock
+    QueuePool _trash_list;
+    atomic_uint32_t _ntrash;
     uint32_t _quantum;
 
     uint32_t _creates; // number of queues created
     uint32_t _deletes; // number of queues deleted
-    uint32_t _drops; // packets dropped because of full queue
     uint32_t _bdrops; // bytes dropped
 
     FairBufferQueue* request_queue();
     void release_queue(FairBufferQueue*);
+    void link_queue(FairBufferQueue*);
+    void unlink_queue(FairBufferQueue*);
+    void collect_trash();
     
-    uint32_t compute_deficit(Packet*);
+    uint32_t compute_deficit(FairBufferQueue*, Packet*);
 
     static int write_handler(const String &, Element *, void *, ErrorHandler *);
     static String read_handler(Element *, void *);
@@ -126,35 +136,43 @@ class FairBufferQueue {
 
   public:
 
-    ReadWriteLock _queue_lock;
-    Packet** _q;
+    // _tail is only written by push() and _head only by pull(), the
+    // counters are shared by both sides
+    Packet* volatile * _q;
     FairBuffer * _fair_buffer;
 
     uint32_t _capacity;
     uint32_t _deficit;
-    uint32_t _size;
-    uint32_t _bsize;
+    atomic_uint32_t _size;
+    atomic_uint32_t _bsize;
     uint32_t _drops;
-    uint32_t _head;
-    uint32_t _tail;
+    volatile uint32_t _head;
+    volatile uint32_t _tail;
     uint32_t _trash;
     Timestamp _last_update;
 
+    EtherAddress _dst;
+    Packet* _pending; // head packet waiting for enough deficit
+    atomic_uint32_t _idle; // not linked in the active ring
+    bool _trashed; // on FairBuffer's trash list
+    FairBufferQueue* volatile _next; // active ring links
+    FairBufferQueue* _prev;
+    uint32_t _metric; // link metric, valid while _metric_epoch is current
+    uint32_t _metric_epoch;
+
     FairBufferQueue(FairBuffer *fair_buffer) : _fair_buffer(fair_buffer) {
       _capacity = _fair_buffer->capacity();
-      _q = new Packet*[_capacity];
+      _q = new Packet*[_capacity]();
       reset();
     }
 
     ~FairBufferQueue() {
-      _queue_lock.acquire_write();
       for(uint32_t i = 0; i < _capacity; i++){
         if(_q[i]) {
           _q[i]->kill();
         }
       } 
       delete[] _q;
-      _queue_lock.release_write();
     }  
 
     void reset() {
@@ -166,37 +184,62 @@ class FairBufferQueue {
       _deficit = 0;
       _trash = 0;
       _last_update = Timestamp(0);
+      _pending = 0;
+      _idle = 1;
+      _trashed = false;
+      _next = 0;
+      _prev = 0;
+      _metric = 0;
+      _metric_epoch = 0;
     }
 
     Packet* pull() {
-      Packet* p = 0;
-      _queue_lock.acquire_write();
-      if(_head != _tail){
-        _head = (_head+1)%_capacity;
-        p = _q[_head];
-        _q[_head] = 0;
-        _size--;
-        _bsize -= p->length();
+      uint32_t h = _head;
+      if(h == _tail){
+        return 0;
       }
-      _queue_lock.release_write();
+      h = (h+1)%_capacity;
+      Packet* p = _q[h];
+      _q[h] = 0;
+      _size--;
+      _bsize -= p->length();
+      Storage::packet_memory_barrier(_q[h], _head);
+      _head = h;
       return(p);
     }
 
     bool push(Packet* p) {
-      bool result = false;
-      _queue_lock.acquire_write();
-      if((_tail+1)%_capacity != _head){
-        _tail++;
-        _tail %= _capacity;
-        _q[_tail] = p;
-        _size++;
-        _bsize += p->length();
-        result = true;
-      } else {
+      uint32_t t = (_tail+1)%_capacity;
+      if(t == _head){
         _drops++;
+        return false;
       }
-      _queue_lock.release_write();
-      return result;
+      _q[t] = p;
+      _size++;
+      _bsize += p->length();
+      Storage::packet_memory_barrier(_q[t], _tail);
+      _tail = t;
+      return true;
+    }
+
+    // Number of queued frames, starting from the head, that go in the
+    // next A-MSDU; *len is set to the length of the resulting frame.
+    uint32_t burst(uint32_t *len) {
+      uint32_t n = 0;
+      *len = 0;
+      uint32_t t = _tail;
+      for (uint32_t i = _head; i != t; i = (i+1)%_capacity) {
+        uint32_t next = _q[(i+1)%_capacity]->length();
+        if (n == 0) {
+          *len = next;
+        } else if (*len + next < _fair_buffer->max_burst()) {
+          *len += (n == 1) ? next + 8 - sizeof(struct click_ether) : next + 4 - sizeof(struct click_ether);
+        } else {
+          break;
+        }
+        n++;
+      }
+      return n;
     }
 
     Packet* aggregate() {
@@ -209,47 +252,51 @@ class FairBufferQueue {
         return pull();
       }
 
-      WritablePacket *wp = pull()->uniqueify();
-
-      if (top() && (wp->length() + top()->length() < _fair_buffer->max_burst())) {
-
-        click_ether *e = (click_ether *)wp->data();
-        uint16_t ether_type = e->ether_type;
-        uint16_t length = htons(wp->length() - sizeof(struct click_ether));
-
-        EtherAddress *dst = new EtherAddress(e->ether_dhost);
-        EtherAddress *src = new EtherAddress(e->ether_shost);
-
-        uint16_t ether_type_pack = htons(_fair_buffer->et());
+      uint32_t len;
+      uint32_t n = burst(&len);
 
-        wp = wp->push(4);
+      Packet *p = pull();
 
-        memcpy(wp->data(), dst->data(), 6);
-        memcpy(wp->data() + 6, src->data(), 6);
-        memcpy(wp->data() + 12, &ether_type_pack, 2);	
-
-        memcpy(wp->data() + 14, &length, 2);
-        memcpy(wp->data() + 16, &ether_type, 2);
-
-        do {
-
-          uint32_t append = top()->length() - sizeof(struct click_ether);
-          wp = wp->put(append+4);
-
-          Packet* q = pull();
-
-          click_ether *qe = (click_ether *)q->data();
-          uint16_t ether_type = qe->ether_type;
-          uint16_t length = htons(q->length() - sizeof(struct click_ether));
-
-          memcpy(wp->data() + (wp->length()-append-4), &length, 2);
-          memcpy(wp->data() + (wp->length()-append-2), &ether_type, 2);
-          memcpy(wp->data() + (wp->length()-append), q->data()+sizeof(struct click_ether), append);
-
-          q->kill();
+      if (n < 2) {
+        return p;
+      }
 
-        } while (top() && (wp->length() + top()->length() < _fair_buffer->max_burst()));
+      // the first MSDU keeps its ethernet type in the A-MSDU header, so
+      // when possible the aggregate is built in place around it
+      WritablePacket *wp;
+      uint32_t first = p->length() - sizeof(struct click_ether);
+      if (!p->shared() && p->headroom() >= 4 && p->tailroom() >= len - p->length() - 4) {
+        wp = p->uniqueify()->push(4);
+        memmove(wp->data(), wp->data() + 4, 12);
+        wp = wp->put(len - wp->length());
+      } else {
+        wp = Packet::make(Packet::default_headroom, 0, len, 0);
+        if (!wp) {
+          return p;
+        }
+        wp->copy_annotations(p);
+        memcpy(wp->data(), p->data(), 12);
+        memcpy(wp->data() + 16, p->data() + 12, first + 2);
+        p->kill();
+      }
 
+      uint16_t ether_type_pack = htons(_fair_buffer->et());
+      uint16_t length = htons(first);
+      memcpy(wp->data() + 12, &ether_type_pack, 2);
+      memcpy(wp->data() + 14, &length, 2);
+      wp->set_mac_header(wp->data(), 14);
+
+      uint8_t *ptr = wp->data() + 18 + first;
+      for (uint32_t i = 1; i < n; i++) {
+        Packet *q = pull();
+        const click_ether *qe = (const click_ether *) q->data();
+        uint32_t append = q->length() - sizeof(struct click_ether);
+        length = htons(append);
+        memcpy(ptr, &length, 2);
+        memcpy(ptr + 2, &qe->ether_type, 2);
+        memcpy(ptr + 4, q->data() + sizeof(struct click_ether), append);
+        ptr += append + 4;
+        q->kill();
       }
 
       return wp;
@@ -273,13 +320,11 @@ class FairBufferQueue {
     }
 
     const Packet* top() {
-      Packet* p = 0;
-      _queue_lock.acquire_write();
-      if(_head != _tail){
-        p = _q[(_head+1)%_capacity];
+      uint32_t h = _head;
+      if(h == _tail){
+        return 0;
       }
-      _queue_lock.release_write();
-      return(p);
+      return(_q[(h+1)%_capacity]);
     }
 
 };
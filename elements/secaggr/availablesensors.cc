@@ -25,7 +25,9 @@ CLICK_DECLS
 
 AvailableSensors::AvailableSensors() 
   :  _master_key(0),
-     _msg(1)
+     _msg(1),
+     _version(1),
+     _all_version(0)
 {
   _sensors = new SensorsTable(0);
 }
@@ -43,10 +45,39 @@ AvailableSensors::configure(Vector<String> &conf, ErrorHandler *errh)
 	for (int i = 0; i < conf.size(); i++) {
 		Element *e = cp_element(conf[i], router(), errh);
 		_as[i] = (AvailableSensors *)e;
+		if (e && !e->cast("AvailableSensors")) {
+			errh->error("%s is not an AvailableSensors", conf[i].c_str());
+			continue;
+		}
+		if (e)
+			_as[i]->_downstream.push_back(this);
 	}
+	changed();
 	return (errh->nerrors() == before ? 0 : -1);
 }
 
+void
+AvailableSensors::rebuild()
+{
+  SensorsTable st(0);
+  fetch_upstream_sensors(&st, true);
+  _all = SensorSet();
+  _all_order.clear();
+  _all_keystream = 0;
+  // sensors we do not know about still contribute the message itself
+  for (int i = 0; i < 256; i++) {
+    _keystreams[i] = sa_keystream(0, _msg);
+  }
+  for (SensorsItr itr = st.begin(); itr != st.end(); itr++) {
+    _all.add(itr.key());
+    _all_order.push_back(itr.key());
+    _keystreams[itr.key()] = sa_keystream(itr.value(), _msg);
+    _all_keystream = sa_add_keystreams(_all_keystream, _keystreams[itr.key()]);
+  }
+  _all_version = _version;
+  _all_msg = _msg;
+}
+
 enum {H_INSERT, H_CLEAR, H_SENSORS};
 
 String
@@ -82,7 +113,7 @@ AvailableSensors::write_handler(const String &in_s, Element *e, void *vparam, Er
     break;
   }
   case H_CLEAR:
-    f->_sensors->clear();
+    f->clear_sensors();
     break;
   }
   return 0;
@@ -19,7 +19,14 @@ class AvailableSensors : public Element { public:
   void add_handlers();
 
   bool add_sensor(uint8_t sensor) { 
-    return _sensors->set(sensor, sa_sensor_key(_master_key, sensor)); 
+    bool result = _sensors->set(sensor, sa_sensor_key(_master_key, sensor)); 
+    changed();
+    return result;
+  }
+
+  void clear_sensors() {
+    _sensors->clear();
+    changed();
   }
 
   uint32_t get_key(uint8_t sensor) { 
@@ -44,68 +51,73 @@ class AvailableSensors : public Element { public:
     }
   }
 
+  // 256-bit set of sensor ids
+  struct SensorSet {
+    uint32_t _bits[8];
+    SensorSet() { memset(_bits, 0, sizeof(_bits)); }
+    SensorSet(const Vector<uint8_t> *sensors) {
+      memset(_bits, 0, sizeof(_bits));
+      for (int i = 0; i < sensors->size(); i++) {
+        add(sensors->at(i));
+      }
+    }
+    bool contains(uint8_t s) const { return _bits[s >> 5] & (1U << (s & 31)); }
+    void add(uint8_t s) { _bits[s >> 5] |= (1U << (s & 31)); }
+  };
+
   Vector<uint8_t>* diff(Vector<uint8_t> *sensors, bool recursive) {
     Vector<uint8_t> *diff = new Vector<uint8_t>();
-    SensorsTable* st = new SensorsTable(0);
-    fetch_upstream_sensors(st, recursive);
-    SensorsItr itr = st->begin();
-    while(itr != st->end()) {
-      bool found = false;
-      for (int j = 0; j < sensors->size(); j++) {
-        if (sensors->at(j) == itr.key()) {
-          found = true;
-          break;
+    SensorSet in(sensors);
+    if (recursive) {
+      refresh();
+      for (int i = 0; i < _all_order.size(); i++) {
+        if (!in.contains(_all_order[i])) {
+          diff->push_front(_all_order[i]);
         }
       }
-      if (!found) {
-        diff->push_front(itr.key());
+    } else {
+      for (SensorsItr itr = _sensors->begin(); itr != _sensors->end(); itr++) {
+        if (!in.contains(itr.key())) {
+          diff->push_front(itr.key());
+        }
       }
-      itr++;
     }
     return diff;
   }
 
   uint32_t get_keystream(uint8_t sensor) { 
-    SensorsTable* st = new SensorsTable(0);
-    fetch_upstream_sensors(st, true);
-    return sa_keystream(st->get(sensor), _msg);
+    refresh();
+    return _keystreams[sensor];
   }
 
   uint32_t get_keystream_p(Vector<uint8_t> *sensors) { 
+    refresh();
     uint32_t keystream = 0;
-    SensorsTable* st = new SensorsTable(0);
-    fetch_upstream_sensors(st, true);
     for (int i = 0; i < sensors->size(); i++) {
-      keystream = sa_add_keystreams(keystream, sa_keystream(st->get(sensors->at(i)), _msg));
+      keystream = sa_add_keystreams(keystream, _keystreams[sensors->at(i)]);
     }
     return keystream;
   }
 
+  // the keystreams of the sensors that are not in the pack, i.e. all of
+  // them minus the ones that are
   uint32_t get_keystream_n(Vector<uint8_t> *sensors) { 
+    refresh();
+    SensorSet in;
     uint32_t keystream = 0;
-    SensorsTable* st = new SensorsTable(0);
-    fetch_upstream_sensors(st, true);
-    SensorsItr itr = st->begin();
-    while(itr != st->end()) {
-      bool found = false;
-      for (int j = 0; j < sensors->size(); j++) {
-        if (sensors->at(j) == itr.key()) {
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
-        keystream = sa_add_keystreams(keystream, sa_keystream(itr.value(), _msg));
+    for (int i = 0; i < sensors->size(); i++) {
+      uint8_t s = sensors->at(i);
+      if (_all.contains(s) && !in.contains(s)) {
+        in.add(s);
+        keystream = sa_add_keystreams(keystream, _keystreams[s]);
       }
-      itr++;
     }
-    return keystream;
+    return (_all_keystream + CLICK_RAND_MAX - keystream) % CLICK_RAND_MAX;
   }
 
   uint8_t nb_sensors () { 
-    SensorsTable* st = new SensorsTable(0);
-    fetch_upstream_sensors(st, true);
-    return st->size(); 
+    refresh();
+    return _all_order.size(); 
   }
 
   SensorsTable* _sensors;
@@ -116,6 +128,32 @@ class AvailableSensors : public Element { public:
   uint8_t _msg;
   class AvailableSensors **_as;
   uint32_t _as_size;
+  Vector<AvailableSensors *> _downstream; // elements that list us upstream
+
+  // flattened view of this element's and all upstream sensors, valid
+  // while _all_version matches _version and _all_msg matches _msg
+  uint32_t _version;
+  uint32_t _all_version;
+  uint8_t _all_msg;
+  SensorSet _all;
+  Vector<uint8_t> _all_order;
+  uint32_t _keystreams[256];
+  uint32_t _all_keystream;
+
+  void changed() {
+    _version++;
+    for (int i = 0; i < _downstream.size(); i++) {
+      _downstream[i]->changed();
+    }
+  }
+
+  void refresh() {
+    if (_all_version != _version || _all_msg != _msg) {
+      rebuild();
+    }
+  }
+
+  void rebuild();
 
   static int write_handler(const String &, Element *, void *, ErrorHandler *);
   static String read_handler(Element *, void *);
@@ -79,12 +79,12 @@ Sink::push(int, Packet *p_in)
     nb_samples = 1;
     keystream = _as->get_keystream(pk->sensors());
   } else if ((pk->type() == SA_PT_PACK_P) || (pk->type() == SA_PT_PACK_N)) {
-    Vector<uint8_t> *sensors = new Vector<uint8_t>();
+    Vector<uint8_t> sensors;
     for (int i = 0; i < pk->sensors(); i++) {
-      sensors->push_front(pk->get_sensor(i));
+      sensors.push_back(pk->get_sensor(i));
     }
     nb_samples = (pk->type() == SA_PT_PACK_P) ? pk->sensors() : _as->nb_sensors() - pk->sensors();
-    keystream = (pk->type() == SA_PT_PACK_P) ? _as->get_keystream_p(sensors) : _as->get_keystream_n(sensors);
+    keystream = (pk->type() == SA_PT_PACK_P) ? _as->get_keystream_p(&sensors) : _as->get_keystream_n(&sensors);
   } else {
      click_chatter("%{element} :: %s :: unknown packet type", this, __func__);
   }
@@ -21,6 +21,7 @@
 #include <click/confparse.hh>
 #include <click/router.hh>
 #include <click/error.hh>
+#include <clicknet/ether.h>
 CLICK_DECLS
 
 QueueThreadTest1::QueueThreadTest1()
@@ -30,16 +31,24 @@ QueueThreadTest1::QueueThreadTest1()
 extern "C" {
 static void *queue_thread_pusher(void *arg)
 {
-    SimpleQueue *sq = static_cast<SimpleQueue *>(arg);
+    QueueThreadTest1 *qtt = static_cast<QueueThreadTest1 *>(arg);
+    SimpleQueue *sq = qtt->_sq;
     while (!sq->router()->running())
 	/* do nothing */;
 
     uint32_t value = 0;
-    Packet *p = Packet::make(4);
+    uint32_t offset = (qtt->_ether ? sizeof(click_ether) : 0);
+    WritablePacket *p = Packet::make(offset + 4);
+    if (qtt->_ether) {
+	click_ether *ethh = reinterpret_cast<click_ether *>(p->data());
+	memset(ethh, 0, sizeof(click_ether));
+	ethh->ether_dhost[5] = 1;
+	ethh->ether_type = htons(ETHERTYPE_IP);
+    }
 
     while (1) {
 	WritablePacket *q = p->uniqueify();
-	*reinterpret_cast<uint32_t *>(q->data()) = value;
+	*reinterpret_cast<uint32_t *>(q->data() + offset) = value;
 	int before_drops = sq->drops();
 	sq->push(0, q->clone());
 	if (sq->drops() == before_drops)
@@ -51,15 +60,24 @@ static void *queue_thread_pusher(void *arg)
 }
 }
 
+int
+QueueThreadTest1::configure(Vector<String> &conf, ErrorHandler *errh)
+{
+    _ether = false;
+    return cp_va_kparse(conf, this, errh,
+			"ETHER", 0, cpBool, &_ether,
+			cpEnd);
+}
+
 int
 QueueThreadTest1::initialize(ErrorHandler *errh)
 {
-    SimpleQueue *sq = static_cast<SimpleQueue *>(output(0).element());
-    if (!sq)
+    _sq = static_cast<SimpleQueue *>(output(0).element());
+    if (!_sq)
 	return errh->error("downstream element must be a type of Queue");
     pthread_attr_t attr;
     pthread_attr_init(&attr);
-    int err = pthread_create(&_push_thread, &attr, queue_thread_pusher, sq);
+    int err = pthread_create(&_push_thread, &attr, queue_thread_pusher, this);
     if (err != 0)
 	return errh->error("cannot start thread: %s", strerror(err));
     else
@@ -79,6 +97,18 @@ QueueThreadTest2::QueueThreadTest2()
 {
 }
 
+int
+QueueThreadTest2::configure(Vector<String> &conf, ErrorHandler *errh)
+{
+    bool ether = false;
+    if (cp_va_kparse(conf, this, errh,
+		     "ETHER", 0, cpBool, &ether,
+		     cpEnd) < 0)
+	return -1;
+    _offset = (ether ? sizeof(click_ether) : 0);
+    return 0;
+}
+
 int
 QueueThreadTest2::initialize(ErrorHandler *)
 {
@@ -97,8 +127,8 @@ QueueThreadTest2::run_task(Task *)
     int i;
     for (i = 0; i < 100; i++)
 	if (Packet *p = input(0).pull()) {
-	    CHECK(p->length() == 4);
-	    CHECK(* reinterpret_cast<const uint32_t *>(p->data()) == _next);
+	    CHECK(p->length() == _offset + 4);
+	    CHECK(* reinterpret_cast<const uint32_t *>(p->data() + _offset) == _next);
 	    p->kill();
 	    _next++;
 	} else
@@ -11,12 +11,19 @@ CLICK_DECLS
 /*
 =c
 
-QueueThreadTest1()
+QueueThreadTest1([ETHER])
 
 =s test
 
 runs regression tests for Queue threading
 
+=d
+
+Pushes numbered packets into the downstream queue from a separate thread.
+If ETHER is true, each packet starts with an Ethernet header, so queues
+that classify frames by address, such as FairBuffer, can be tested too.
+Default is false.
+
 =e
 
   QueueThreadTest1 -> Queue -> QueueThreadTest2
@@ -30,9 +37,13 @@ class QueueThreadTest1 : public Element { public:
     const char *class_name() const		{ return "QueueThreadTest1"; }
     const char *port_count() const		{ return PORTS_0_1; }
 
+    int configure(Vector<String> &, ErrorHandler *) CLICK_COLD;
     int initialize(ErrorHandler *) CLICK_COLD;
     void cleanup(CleanupStage) CLICK_COLD;
 
+    SimpleQueue *_sq;
+    bool _ether;
+
   private:
 
     pthread_t _push_thread;
@@ -44,12 +55,17 @@ class QueueThreadTest1 : public Element { public:
 /*
 =c
 
-QueueThreadTest2()
+QueueThreadTest2([ETHER])
 
 =s test
 
 runs regression tests for Queue threading
 
+=d
+
+Checks that packets pushed by QueueThreadTest1 arrive in order. ETHER must
+match the upstream QueueThreadTest1.
+
 =e
 
   QueueThreadTest1 -> Queue -> QueueThreadTest2
@@ -64,12 +80,14 @@ class QueueThreadTest2 : public Element { public:
     const char *port_count() const		{ return PORTS_1_0; }
     const char *processing() const		{ return PULL; }
 
+    int configure(Vector<String> &, ErrorHandler *) CLICK_COLD;
     int initialize(ErrorHandler *) CLICK_COLD;
     bool run_task(Task *);
 
   private:
 
     Task _task;
+    uint32_t _offset;
     uint32_t _next;
     uint32_t _last_msg;
     NotifierSignal _signal;
@@ -0,0 +1,160 @@
+// -*- c-basic-offset: 4 -*-
+/*
+ * selecttest.{cc,hh} -- benchmark element for file descriptor selection
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, subject to the conditions
+ * listed in the Click LICENSE file. These conditions include: you must
+ * preserve this copyright notice, and you cannot mention the copyright
+ * holders in advertising related to the Software without their permission.
+ * The Software is provided WITHOUT ANY WARRANTY, EXPRESS OR IMPLIED. This
+ * notice is a summary of the Click LICENSE file; the license in that file is
+ * legally binding.
+ */
+
+#include <click/config.h>
+#include "selecttest.hh"
+#include <click/glue.hh>
+#include <click/error.hh>
+#include <click/args.hh>
+#include <click/router.hh>
+#include <unistd.h>
+#include <fcntl.h>
+CLICK_DECLS
+
+SelectTest::SelectTest()
+    : _nidle(0), _nactive(1), _limit(100000), _edge(false), _stop(false),
+      _count(0), _errors(0)
+{
+}
+
+int
+SelectTest::configure(Vector<String> &conf, ErrorHandler *errh)
+{
+    if (Args(conf, this, errh)
+	.read("IDLE", _nidle)
+	.read("ACTIVE", _nactive)
+	.read("LIMIT", _limit)
+	.read("EDGE", _edge)
+	.read("STOP", _stop)
+	.complete() < 0)
+	return -1;
+    if (_nidle < 0 || _nactive < 0 || _limit < 0)
+	return errh->error("IDLE, ACTIVE, and LIMIT must be nonnegative");
+    return 0;
+}
+
+int
+SelectTest::open_pipe(bool active, ErrorHandler *errh)
+{
+    int p[2];
+    if (pipe(p) < 0)
+	return errh->error("pipe: %s", strerror(errno));
+    _fds.push_back(p[0]);
+    _fds.push_back(p[1]);
+    fcntl(p[0], F_SETFL, O_NONBLOCK);
+    fcntl(p[1], F_SETFL, O_NONBLOCK);
+    if (p[0] >= _write_fd.size())
+	_write_fd.resize(p[0] + 1, -1);
+
+    int mask = SELECT_READ;
+    if (active) {
+	_write_fd[p[0]] = p[1];
+	ignore_result(write(p[1], "", 1));
+	if (_edge)
+	    mask |= SELECT_EDGE;
+    }
+    if (add_select(p[0], mask) < 0)
+	return errh->error("add_select(%d) failed", p[0]);
+    return 0;
+}
+
+int
+SelectTest::initialize(ErrorHandler *errh)
+{
+    // interleave idle and active pipes so that neither group sits at one
+    // end of the descriptor table
+    int ni = 0, na = 0;
+    while (ni < _nidle || na < _nactive)
+	if (na < _nactive && (ni >= _nidle
+			      || (int64_t) na * _nidle <= (int64_t) ni * _nactive)) {
+	    if (open_pipe(true, errh) < 0)
+		return -1;
+	    ++na;
+	} else {
+	    if (open_pipe(false, errh) < 0)
+		return -1;
+	    ++ni;
+	}
+    return 0;
+}
+
+void
+SelectTest::cleanup(CleanupStage)
+{
+    for (int i = 0; i < _fds.size(); ++i)
+	close(_fds[i]);
+    _fds.clear();
+}
+
+void
+SelectTest::finish()
+{
+    _elapsed = Timestamp::now_steady() - _start;
+    for (int i = 0; i < _fds.size(); i += 2)
+	remove_select(_fds[i], SELECT_READ);
+    double secs = _elapsed.doubleval();
+    click_chatter("%p{element}: %d calls (%d idle, %d active%s) in %p{timestamp}s, %.0f calls/s",
+		  this, _count, _nidle, _nactive, _edge ? ", edge" : "",
+		  &_elapsed, secs > 0 ? _count / secs : 0.);
+    if (_stop)
+	router()->please_stop_driver();
+}
+
+void
+SelectTest::selected(int fd, int)
+{
+    if (fd >= _write_fd.size() || _write_fd[fd] < 0) {
+	++_errors;
+	return;
+    }
+    if (!_count)
+	_start = Timestamp::now_steady();
+
+    // drain the pipe, then put the token back
+    char buf[16];
+    while (read(fd, buf, sizeof(buf)) > 0)
+	/* do nothing */;
+    ignore_result(write(_write_fd[fd], "", 1));
+
+    if (++_count == _limit)
+	finish();
+}
+
+String
+SelectTest::read_handler(Element *e, void *user_data)
+{
+    SelectTest *st = static_cast<SelectTest *>(e);
+    switch ((uintptr_t) user_data) {
+    case h_count:
+	return String(st->_count);
+    case h_errors:
+	return String(st->_errors);
+    case h_elapsed:
+    default:
+	return st->_elapsed.unparse();
+    }
+}
+
+void
+SelectTest::add_handlers()
+{
+    add_read_handler("count", read_handler, h_count);
+    add_read_handler("errors", read_handler, h_errors);
+    add_read_handler("elapsed", read_handler, h_elapsed);
+}
+
+CLICK_ENDDECLS
+ELEMENT_REQUIRES(userlevel)
+EXPORT_ELEMENT(SelectTest)
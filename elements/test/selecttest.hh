@@ -0,0 +1,112 @@
+// -*- c-basic-offset: 4 -*-
+#ifndef CLICK_SELECTTEST_HH
+#define CLICK_SELECTTEST_HH
+#include <click/element.hh>
+#include <click/vector.hh>
+#include <click/timestamp.hh>
+CLICK_DECLS
+
+/*
+=c
+
+SelectTest([I<keywords>])
+
+=s test
+
+benchmarks file descriptor selection
+
+=d
+
+SelectTest opens IDLE pipes that never become readable and ACTIVE pipes that
+always are, and registers interest in all of them with add_select().  Each
+time an active pipe is selected, SelectTest reads its token byte and writes
+it back, so every active pipe is ready on every driver iteration.  After
+LIMIT selected() calls SelectTest removes its selectors and reports the
+elapsed time and call rate to standard error.
+
+The cost per call depends on how the driver waits for events: poll() and
+select() scan every registered descriptor, idle or not, on each iteration,
+while epoll() and kqueue() report only the ready ones.
+
+SelectTest does not route packets.
+
+Keyword arguments are:
+
+=over 8
+
+=item IDLE
+
+Integer. Number of idle pipes. Default is 0.
+
+=item ACTIVE
+
+Integer. Number of active pipes. Default is 1.
+
+=item LIMIT
+
+Integer. Number of selected() calls to run. Default is 100000.
+
+=item EDGE
+
+Boolean. If true, register the active pipes with SELECT_EDGE; SelectTest
+drains each pipe completely. Default is false.
+
+=item STOP
+
+Boolean. If true, stop the driver after LIMIT calls. Default is false.
+
+=back
+
+=h count r
+
+Returns the number of selected() calls so far.
+
+=h errors r
+
+Returns the number of selected() calls for idle pipes, which should be 0.
+
+=h elapsed r
+
+Returns the time taken by the LIMIT calls, once complete.
+
+=a TimerTest
+*/
+
+class SelectTest : public Element { public:
+
+    SelectTest() CLICK_COLD;
+
+    const char *class_name() const		{ return "SelectTest"; }
+
+    int configure(Vector<String> &conf, ErrorHandler *errh) CLICK_COLD;
+    int initialize(ErrorHandler *errh) CLICK_COLD;
+    void cleanup(CleanupStage stage) CLICK_COLD;
+    void add_handlers() CLICK_COLD;
+
+    void selected(int fd, int mask);
+
+  private:
+
+    int _nidle;
+    int _nactive;
+    int _limit;
+    bool _edge;
+    bool _stop;
+
+    Vector<int> _fds;		// pipe ends, read end first
+    Vector<int> _write_fd;	// write end for each active read end, or -1
+    int _count;
+    int _errors;
+    Timestamp _start;
+    Timestamp _elapsed;
+
+    int open_pipe(bool active, ErrorHandler *errh);
+    void finish();
+
+    enum { h_count, h_errors, h_elapsed };
+    static String read_handler(Element *e, void *user_data) CLICK_COLD;
+
+};
+
+CLICK_ENDDECLS
+#endif
@@ -22,10 +22,12 @@
 #include <click/error.hh>
 #include <click/args.hh>
 #include <click/master.hh>
+#include <click/timerset.hh>
 CLICK_DECLS
 
 TimerTest::TimerTest()
-    : _timer(this), _benchmark(0)
+    : _timer(this), _benchmark(0), _fire(false), _stop(false),
+      _spread(1, 0), _bench(0), _fired(0)
 {
 }
 
@@ -33,13 +35,19 @@ int
 TimerTest::configure(Vector<String> &conf, ErrorHandler *errh)
 {
     Timestamp delay;
-    bool schedule = false;
+    bool schedule = false, wheel = false, wheel_set;
     if (Args(conf, this, errh)
 	.read("BENCHMARK", _benchmark)
 	.read("DELAY", delay)
 	.read("SCHEDULE", schedule)
+	.read("FIRE", _fire)
+	.read("SPREAD", _spread)
+	.read("STOP", _stop)
+	.read("WHEEL", wheel).read_status(wheel_set)
 	.complete() < 0)
 	return -1;
+    if (wheel_set)
+	home_thread()->timer_set().set_timer_wheel(wheel);
     _timer.initialize(this);
     if (schedule || delay)
 	_timer.schedule_after(delay);
@@ -61,20 +69,70 @@ TimerTest::initialize(ErrorHandler *)
 	explicit_do_nothing_timer.initialize(this);
     } else {
 	Timestamp now = Timestamp::now_steady();
-	Timer *ts = new Timer[_benchmark];
+	_bench = new Timer[_benchmark];
 	for (int i = 0; i < _benchmark; ++i) {
-	    ts[i].assign();
-	    ts[i].initialize(this);
+	    _bench[i].assign(fire_hook, this);
+	    _bench[i].initialize(this);
+	}
+	benchmark_schedules(_bench, _benchmark, now);
+	report("schedule", _benchmark, now);
+	now = Timestamp::now_steady();
+	benchmark_changes(_bench, _benchmark, now);
+	report("change", 6 * _benchmark, now);
+	now = Timestamp::now_steady();
+	benchmark_fires(_bench, _benchmark, now);
+	report("unschedule", _benchmark, now);
+
+	if (_fire) {
+	    _fire_start = Timestamp::now_steady();
+	    uint32_t spread = _spread.usecval();
+	    for (int i = 0; i < _benchmark; ++i)
+		_bench[i].schedule_at_steady(_fire_start + Timestamp::make_usec(click_random(0, spread)));
+	} else {
+	    delete[] _bench;
+	    _bench = 0;
 	}
-	benchmark_schedules(ts, _benchmark, now);
-	benchmark_changes(ts, _benchmark, now);
-	benchmark_fires(ts, _benchmark, now);
-	delete[] ts;
     }
 
     return 0;
 }
 
+void
+TimerTest::cleanup(CleanupStage)
+{
+    delete[] _bench;
+    _bench = 0;
+}
+
+void
+TimerTest::report(const char *what, int n, const Timestamp &start)
+{
+    Timestamp elapsed = Timestamp::now_steady() - start;
+    double secs = elapsed.doubleval();
+    click_chatter("%p{element}: %s %d timers%s in %p{timestamp}s, %.0f/s",
+		  this, what, n,
+		  home_thread()->timer_set().timer_wheel() ? " (wheel)" : "",
+		  &elapsed, secs > 0 ? n / secs : 0.);
+}
+
+void
+TimerTest::fire_hook(Timer *t, void *user_data)
+{
+    TimerTest *tt = static_cast<TimerTest *>(user_data);
+    Timestamp late = Timestamp::now_steady() - t->expiry_steady();
+    tt->_late_sum += late;
+    if (late > tt->_late_max)
+	tt->_late_max = late;
+    if (++tt->_fired == tt->_benchmark) {
+	Timestamp late_avg = tt->_late_sum / tt->_benchmark;
+	tt->report("fire", tt->_benchmark, tt->_fire_start);
+	click_chatter("%p{element}: timers ran %p{timestamp}s late on average, %p{timestamp}s at most",
+		      tt, &late_avg, &tt->_late_max);
+	if (tt->_stop)
+	    tt->router()->please_stop_driver();
+    }
+}
+
 void
 TimerTest::run_timer(Timer *t)
 {
@@ -118,6 +176,8 @@ TimerTest::read_handler(Element *e, void *user_data)
     switch ((uintptr_t) user_data) {
     case h_scheduled:
 	return String(tt->_timer.scheduled());
+    case h_fired:
+	return String(tt->_fired);
     case h_expiry:
     default:
 	return String(tt->_timer.expiry_steady());
@@ -161,6 +221,7 @@ TimerTest::add_handlers()
     add_read_handler("expiry", read_handler, h_expiry);
     add_write_handler("schedule_after", write_handler, h_schedule_after);
     add_write_handler("unschedule", write_handler, h_unschedule);
+    add_read_handler("fired", read_handler, h_fired);
 }
 
 CLICK_ENDDECLS
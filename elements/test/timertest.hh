@@ -39,7 +39,29 @@ is printed to standard error.
 
 Integer.  If set to a positive number, then TimerTest runs a timer
 manipulation benchmark at installation time involving BENCHMARK total
-timers.  Default is 0 (don't benchmark).
+timers, and reports the time taken to schedule, reschedule, and unschedule
+them to standard error.  Default is 0 (don't benchmark).
+
+=item FIRE
+
+Boolean.  If true, then after the BENCHMARK manipulations TimerTest schedules
+all BENCHMARK timers to expire at random within SPREAD, lets them fire, and
+reports the firing rate and how late the timers ran.  Default is false.
+
+=item SPREAD
+
+Timestamp.  Interval over which FIRE timers expire.  Default is 1s.
+
+=item STOP
+
+Boolean.  If true, stop the driver once all FIRE timers have fired.  Default
+is false.
+
+=item WHEEL
+
+Boolean.  If given, select the timing wheel (true) or the plain timer heap
+(false) for TimerTest's home thread; see TimerSet::set_timer_wheel().  By
+default the thread's setting is left alone.
 
 =back
 
@@ -59,6 +81,10 @@ Schedule the TimerTest's timer to fire after a given time.
 
 Unschedule the TimerTest's timer.
 
+=h fired r
+
+Integer.  Returns the number of FIRE benchmark timers that have fired.
+
 */
 
 class TimerTest : public Element { public:
@@ -69,6 +95,7 @@ class TimerTest : public Element { public:
 
     int configure(Vector<String> &conf, ErrorHandler *errh) CLICK_COLD;
     int initialize(ErrorHandler *errh) CLICK_COLD;
+    void cleanup(CleanupStage stage) CLICK_COLD;
     void add_handlers() CLICK_COLD;
 
     void run_timer(Timer *t);
@@ -77,12 +104,23 @@ class TimerTest : public Element { public:
 
     Timer _timer;
     int _benchmark;
+    bool _fire;
+    bool _stop;
+    Timestamp _spread;
+
+    Timer *_bench;
+    int _fired;
+    Timestamp _fire_start;
+    Timestamp _late_sum;
+    Timestamp _late_max;
 
     void benchmark_schedules(Timer *ts, int nts, const Timestamp &now);
     void benchmark_changes(Timer *ts, int nts, const Timestamp &now);
     void benchmark_fires(Timer *ts, int nts, const Timestamp &now);
+    void report(const char *what, int n, const Timestamp &start);
+    static void fire_hook(Timer *t, void *user_data);
 
-    enum { h_scheduled, h_expiry, h_schedule_after, h_unschedule };
+    enum { h_scheduled, h_expiry, h_schedule_after, h_unschedule, h_fired };
     static String read_handler(Element *e, void *user_data) CLICK_COLD;
     static int write_handler(const String &str, Element *e, void *user_data, ErrorHandler *errh) CLICK_COLD;
 
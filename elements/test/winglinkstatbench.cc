@@ -0,0 +1,127 @@
+/*
+ * winglinkstatbench.{cc,hh}
+ *
+ * Copyright (c) 2009 CREATE-NET
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, subject to the conditions
+ * listed in the Click LICENSE file. These conditions include: you must
+ * preserve this copyright notice, and you cannot mention the copyright
+ * holders in advertising related to the Software without their permission.
+ * The Software is provided WITHOUT ANY WARRANTY, EXPRESS OR IMPLIED. This
+ * notice is a summary of the Click LICENSE file; the license in that file is
+ * legally binding.
+ */
+
+#include <click/config.h>
+#include "winglinkstatbench.hh"
+#include <click/args.hh>
+#include "elements/wing/winglinkstat.hh"
+CLICK_DECLS
+
+WINGLinkStatBench::WINGLinkStatBench() :
+	_link_stat(0), _limit(1000), _repeat(1000), _replayed(0) {
+}
+
+WINGLinkStatBench::~WINGLinkStatBench() {
+}
+
+int WINGLinkStatBench::configure(Vector<String> &conf, ErrorHandler *errh) {
+
+	return Args(conf, this, errh)
+		.read_mp("LS", ElementCastArg("WINGLinkStat"), _link_stat)
+		.read_p("LIMIT", _limit)
+		.read_p("REPEAT", _repeat)
+		.complete();
+
+}
+
+void WINGLinkStatBench::cleanup(CleanupStage) {
+	clear();
+}
+
+Packet *
+WINGLinkStatBench::simple_action(Packet *p) {
+	if (_probes.size() < _limit) {
+		if (Packet *q = p->clone()) {
+			_probes.push_back(q);
+		}
+	}
+	return p;
+}
+
+void WINGLinkStatBench::run(uint32_t repeat) {
+	_replayed = 0;
+	Timestamp start = Timestamp::now_steady();
+	for (uint32_t r = 0; r < repeat; r++) {
+		for (int x = 0; x < _probes.size(); x++) {
+			if (Packet *q = _probes[x]->clone()) {
+				_link_stat->simple_action(q);
+				_replayed++;
+			}
+		}
+	}
+	_elapsed = Timestamp::now_steady() - start;
+}
+
+void WINGLinkStatBench::clear() {
+	for (int x = 0; x < _probes.size(); x++) {
+		_probes[x]->kill();
+	}
+	_probes.clear();
+}
+
+enum {
+	H_RUN, H_DISCARD, H_COUNT, H_REPLAYED, H_ELAPSED, H_RATE
+};
+
+String WINGLinkStatBench::read_handler(Element *e, void *thunk) {
+	WINGLinkStatBench *td = (WINGLinkStatBench *) e;
+	switch ((uintptr_t) thunk) {
+	case H_COUNT:
+		return String(td->_probes.size()) + "\n";
+	case H_REPLAYED:
+		return String(td->_replayed) + "\n";
+	case H_ELAPSED:
+		return td->_elapsed.unparse() + "\n";
+	case H_RATE: {
+		double secs = td->_elapsed.doubleval();
+		return String(secs > 0 ? (uint32_t) (td->_replayed / secs) : 0) + "\n";
+	}
+	default:
+		return String() + "\n";
+	}
+}
+
+int WINGLinkStatBench::write_handler(const String &in_s, Element *e, void *vparam, ErrorHandler *errh) {
+	WINGLinkStatBench *f = (WINGLinkStatBench *) e;
+	String s = cp_uncomment(in_s);
+	switch ((intptr_t) vparam) {
+	case H_RUN: {
+		uint32_t repeat = f->_repeat;
+		if (s && !IntArg().parse(s, repeat))
+			return errh->error("repeat parameter must be unsigned");
+		f->run(repeat);
+		break;
+	}
+	case H_DISCARD: {
+		f->clear();
+		break;
+	}
+	}
+	return 0;
+}
+
+void WINGLinkStatBench::add_handlers() {
+	add_read_handler("count", read_handler, H_COUNT);
+	add_read_handler("replayed", read_handler, H_REPLAYED);
+	add_read_handler("elapsed", read_handler, H_ELAPSED);
+	add_read_handler("rate", read_handler, H_RATE);
+	add_write_handler("run", write_handler, H_RUN);
+	add_write_handler("clear", write_handler, H_DISCARD);
+}
+
+CLICK_ENDDECLS
+EXPORT_ELEMENT(WINGLinkStatBench)
+ELEMENT_REQUIRES(WINGLinkStat)
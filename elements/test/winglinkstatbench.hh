@@ -0,0 +1,78 @@
+#ifndef CLICK_WINGLINKSTATBENCH_HH
+#define CLICK_WINGLINKSTATBENCH_HH
+#include <click/element.hh>
+CLICK_DECLS
+
+/*
+ * =c
+ * WINGLinkStatBench(LS, [LIMIT, REPEAT])
+ * =s test
+ * Replays recorded link probes through WINGLinkStat.
+ * =d
+ * Passes packets through unchanged, keeping a copy of the first LIMIT
+ * of them (default 1000). Place it in front of a WINGLinkStat to record
+ * the probes that element receives. Writing to the run handler feeds
+ * the recorded probes to the LS element REPEAT times (default 1000) and
+ * measures how many probes per second WINGLinkStat and its link metric
+ * process.
+ *
+ * The replay goes through LS's normal receive path, so it changes live
+ * state just as if the probes had arrived again: they are added to LS's
+ * probe windows and rate tables, and the link metrics computed from them
+ * go through LS's metric element into the link table. Only use
+ * WINGLinkStatBench in benchmark configurations, or give it a
+ * WINGLinkStat whose link table no routing element uses.
+ * =h run write-only
+ * Replays the recorded probes. Takes an optional repeat count.
+ * =h clear write-only
+ * Discards the recorded probes.
+ * =h count read-only
+ * Number of recorded probes.
+ * =h replayed read-only
+ * Number of probes replayed by the last run.
+ * =h elapsed read-only
+ * Duration of the last run.
+ * =h rate read-only
+ * Probes per second processed by the last run.
+ * =e
+ *  ncl[3] -> bench :: WINGLinkStatBench(LS es) -> es;
+ * =a WINGLinkStat
+ */
+
+class WINGLinkStatBench: public Element {
+
+public:
+
+	WINGLinkStatBench();
+	~WINGLinkStatBench();
+
+	const char *class_name() const { return "WINGLinkStatBench"; }
+	const char *port_count() const { return PORTS_1_1; }
+	const char *processing() const { return AGNOSTIC; }
+
+	int configure(Vector<String> &, ErrorHandler *);
+	void cleanup(CleanupStage);
+	void add_handlers();
+
+	Packet *simple_action(Packet *);
+
+private:
+
+	class WINGLinkStat *_link_stat;
+	Vector<Packet *> _probes;
+	int _limit;
+	uint32_t _repeat;
+
+	uint32_t _replayed;
+	Timestamp _elapsed;
+
+	void run(uint32_t);
+	void clear();
+
+	static int write_handler(const String &, Element *, void *, ErrorHandler *);
+	static String read_handler(Element *, void *);
+
+};
+
+CLICK_ENDDECLS
+#endif
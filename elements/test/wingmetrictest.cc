@@ -0,0 +1,70 @@
+// -*- c-basic-offset: 4 -*-
+/*
+ * wingmetrictest.{cc,hh} -- regression test element for WING link metrics
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, subject to the conditions
+ * listed in the Click LICENSE file. These conditions include: you must
+ * preserve this copyright notice, and you cannot mention the copyright
+ * holders in advertising related to the Software without their permission.
+ * The Software is provided WITHOUT ANY WARRANTY, EXPRESS OR IMPLIED. This
+ * notice is a summary of the Click LICENSE file; the license in that file is
+ * legally binding.
+ */
+
+#include <click/config.h>
+#include "wingmetrictest.hh"
+#include <click/error.hh>
+#include "elements/wing/wingettmetric.hh"
+#include "elements/wing/wingetxmetric.hh"
+CLICK_DECLS
+
+WINGMetricTest::WINGMetricTest()
+{
+}
+
+static unsigned
+etx(int ack_prob, int data_prob)
+{
+    if (!ack_prob || !data_prob || ack_prob < 30 || data_prob < 30)
+	return 999999;
+    return 100 * 100 * 100 / (ack_prob * data_prob) - 100;
+}
+
+int
+WINGMetricTest::initialize(ErrorHandler *errh)
+{
+    static const int legacy_rates[] = { 2, 4, 11, 22, 12, 18, 24, 36, 48, 72, 96, 108 };
+    static const int sizes[] = { 1, 60, 100, 250, 1000, 1500, 2346 };
+    int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    for (int ack = -1; ack <= 102; ack++)
+	for (int data = -1; data <= 102; data++) {
+	    if (WINGETXMetric::compute_metric(ack, data) != etx(ack, data))
+		return errh->error("%s:%d: ETX mismatch at %d/%d", __FILE__, __LINE__, ack, data);
+
+	    for (int s = 0; s < nsizes; s++) {
+		for (unsigned r = 0; r < sizeof(legacy_rates) / sizeof(legacy_rates[0]); r++) {
+		    int rate = legacy_rates[r];
+		    unsigned got = WINGETTMetric::compute_metric(ack, data, rate, sizes[s], PROBE_TYPE_LEGACY);
+		    unsigned want = WINGETTMetric::calc_metric(ack, data, rate, sizes[s], PROBE_TYPE_LEGACY);
+		    if (got != want)
+			return errh->error("%s:%d: ETT mismatch at %d/%d rate %d size %d: %u != %u", __FILE__, __LINE__, ack, data, rate, sizes[s], got, want);
+		}
+		for (int mcs = 0; mcs < 8; mcs++) {
+		    unsigned got = WINGETTMetric::compute_metric(ack, data, mcs, sizes[s], PROBE_TYPE_HT);
+		    unsigned want = WINGETTMetric::calc_metric(ack, data, mcs, sizes[s], PROBE_TYPE_HT);
+		    if (got != want)
+			return errh->error("%s:%d: ETT mismatch at %d/%d mcs %d size %d: %u != %u", __FILE__, __LINE__, ack, data, mcs, sizes[s], got, want);
+		}
+	    }
+	}
+
+    errh->message("All tests pass!");
+    return 0;
+}
+
+EXPORT_ELEMENT(WINGMetricTest)
+ELEMENT_REQUIRES(WINGETTMetric WINGETXMetric)
+CLICK_ENDDECLS
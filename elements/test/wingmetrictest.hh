@@ -0,0 +1,36 @@
+// -*- c-basic-offset: 4 -*-
+#ifndef CLICK_WINGMETRICTEST_HH
+#define CLICK_WINGMETRICTEST_HH
+#include <click/element.hh>
+CLICK_DECLS
+
+/*
+=c
+
+WINGMetricTest()
+
+=s test
+
+runs regression tests for the WING link metrics
+
+=d
+
+WINGMetricTest checks at initialization time that the table-driven ETX and
+ETT computations of WINGETXMetric and WINGETTMetric return exactly what the
+direct airtime computation returns, for every pair of delivery ratios and a
+range of rates and probe sizes. It does not route packets.
+
+*/
+
+class WINGMetricTest : public Element { public:
+
+    WINGMetricTest() CLICK_COLD;
+
+    const char *class_name() const		{ return "WINGMetricTest"; }
+
+    int initialize(ErrorHandler *) CLICK_COLD;
+
+};
+
+CLICK_ENDDECLS
+#endif
@@ -50,13 +50,18 @@
 # include <net/if.h>
 # include <features.h>
 # if __GLIBC__ >= 2 && __GLIBC_MINOR__ >= 1
-#  include <netpacket/packet.h>
+// the kernel header rather than <netpacket/packet.h>, for the TPACKET_V3 ring
+#  include <linux/if_packet.h>
 #  include <net/ethernet.h>
 # else
 #  include <net/if_packet.h>
 #  include <linux/if_packet.h>
 #  include <linux/if_ether.h>
 # endif
+# if defined(TPACKET3_HDRLEN)
+#  include <sys/mman.h>
+#  define FROMDEVICE_ALLOW_MMAP 1
+# endif
 #endif
 
 CLICK_DECLS
@@ -68,6 +73,9 @@ FromDevice::FromDevice()
 #endif
 #if FROMDEVICE_ALLOW_PCAP
       _pcap(0), _pcap_complaints(0),
+#endif
+#if FROMDEVICE_ALLOW_LINUX
+      _ring(0), _ring_timer(this),
 #endif
       _datalink(-1), _count(0), _promisc(0), _snaplen(0)
 {
@@ -89,6 +97,11 @@ FromDevice::configure(Vector<String> &conf, ErrorHandler *errh)
     _headroom += (4 - (_headroom + 2) % 4) % 4; // default 4/2 alignment
     _force_ip = false;
     _burst = 1;
+#if FROMDEVICE_ALLOW_LINUX
+    _ring_block_size = 1 << 18;
+    _ring_blocks = 16;
+    _ring_timeout = 1;
+#endif
     String bpf_filter, capture, encap_type;
     bool has_encap;
     if (Args(conf, this, errh)
@@ -105,6 +118,11 @@ FromDevice::configure(Vector<String> &conf, ErrorHandler *errh)
 	.read("ENCAP", WordArg(), encap_type).read_status(has_encap)
 	.read("BURST", _burst)
 	.read("TIMESTAMP", timestamp)
+#if FROMDEVICE_ALLOW_LINUX
+	.read("BLOCK_SIZE", _ring_block_size)
+	.read("BLOCKS", _ring_blocks)
+	.read("BLOCK_TIMEOUT", _ring_timeout)
+#endif
 	.complete() < 0)
 	return -1;
     if (_snaplen > 8190 || _snaplen < 14)
@@ -139,6 +157,10 @@ FromDevice::configure(Vector<String> &conf, ErrorHandler *errh)
     else if (capture == "LINUX")
 	_method = method_linux;
 #endif
+#if FROMDEVICE_ALLOW_MMAP
+    else if (capture == "MMAP" || capture == "PACKET_RING")
+	_method = method_mmap;
+#endif
 #if FROMDEVICE_ALLOW_PCAP
     else if (capture == "PCAP")
 	_method = method_pcap;
@@ -152,6 +174,15 @@ FromDevice::configure(Vector<String> &conf, ErrorHandler *errh)
 
     if (bpf_filter && _method != method_pcap)
 	errh->warning("not using METHOD PCAP, BPF filter ignored");
+#if FROMDEVICE_ALLOW_MMAP
+    if (_method == method_mmap) {
+	unsigned frame = TPACKET_ALIGN(TPACKET3_HDRLEN + _snaplen);
+	if (_ring_block_size < frame || _ring_block_size % getpagesize())
+	    return errh->error("BLOCK_SIZE must be a multiple of the page size, at least %u", frame);
+	if (_ring_blocks < 2)
+	    return errh->error("BLOCKS out of range");
+    }
+#endif
 
     _sniffer = sniffer;
     _promisc = promisc;
@@ -230,6 +261,178 @@ FromDevice::set_promiscuous(int fd, String ifname, bool promisc)
 
     return was_promisc;
 }
+
+#if FROMDEVICE_ALLOW_MMAP
+/* A TPACKET_V3 receive ring. Packets point into the ring and a block goes
+ * back to the kernel once FromDevice is done walking it and every packet
+ * taken from it has been freed, on whatever thread. The ring is reference
+ * counted so that it outlives the element while packets are still around. */
+class FromDeviceRing { public:
+
+    struct Block {
+	FromDeviceRing *_ring;
+	tpacket_block_desc *_desc;
+	atomic_uint32_t _refs;
+	volatile bool _walked;	// still ours, though marked TP_STATUS_USER
+    };
+
+    FromDeviceRing(unsigned char *map, unsigned block_size, unsigned nblocks)
+	: _map(map), _block_size(block_size), _nblocks(nblocks), _next(0),
+	  _blocks(new Block[nblocks]), _drops(0) {
+	_refs = 1;
+	_held = 0;
+	for (unsigned i = 0; i < nblocks; i++) {
+	    _blocks[i]._ring = this;
+	    _blocks[i]._desc = (tpacket_block_desc *) (map + i * block_size);
+	    _blocks[i]._refs = 0;
+	    _blocks[i]._walked = false;
+	}
+    }
+
+    Block *ready_block() {
+	Block *b = &_blocks[_next];
+	if (b->_walked || !(b->_desc->hdr.bh1.block_status & TP_STATUS_USER))
+	    return 0;
+	// read the block only after seeing its status
+	__sync_synchronize();
+	_next = (_next + 1 == _nblocks ? 0 : _next + 1);
+	_refs++;
+	_held++;
+	b->_refs = 1;
+	b->_walked = true;
+	return b;
+    }
+
+    void release(Block *b) {
+	if (b->_refs.dec_and_test()) {
+	    __sync_synchronize();
+	    b->_desc->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	    __sync_synchronize();
+	    b->_walked = false;
+	    _held--;
+	    unref();
+	}
+    }
+
+    static void release_frame(unsigned char *, size_t, void *arg) {
+	Block *b = (Block *) arg;
+	b->_ring->release(b);
+    }
+
+    void unref() {
+	if (_refs.dec_and_test()) {
+	    munmap(_map, (size_t) _block_size * _nblocks);
+	    delete[] _blocks;
+	    delete this;
+	}
+    }
+
+    unsigned char *_map;
+    unsigned _block_size;
+    unsigned _nblocks;
+    unsigned _next;
+    Block *_blocks;
+    atomic_uint32_t _refs;	// one for the element, one per block held
+    atomic_uint32_t _held;	// blocks walked but not yet released
+    uint32_t _drops;
+
+};
+
+int
+FromDevice::open_ring(ErrorHandler *errh)
+{
+    int version = TPACKET_V3;
+    if (setsockopt(_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+	return errh->error("%s: PACKET_VERSION: %s", _ifname.c_str(), strerror(errno));
+
+    // frames are variable-sized in TPACKET_V3, tp_frame_size only has to
+    // be consistent with the block size
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = _ring_block_size;
+    req.tp_block_nr = _ring_blocks;
+    req.tp_frame_size = TPACKET_ALIGN(TPACKET3_HDRLEN + _snaplen);
+    req.tp_frame_nr = (_ring_block_size / req.tp_frame_size) * _ring_blocks;
+    req.tp_retire_blk_tov = _ring_timeout;
+    if (setsockopt(_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0)
+	return errh->error("%s: PACKET_RX_RING: %s", _ifname.c_str(), strerror(errno));
+
+    size_t size = (size_t) _ring_block_size * _ring_blocks;
+    void *map = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED)
+	return errh->error("%s: mmap: %s", _ifname.c_str(), strerror(errno));
+
+    _ring = new FromDeviceRing((unsigned char *) map, _ring_block_size, _ring_blocks);
+    _ring_timer.initialize(this);
+    return 0;
+}
+
+int
+FromDevice::ring_dispatch()
+{
+    // The kernel fills the blocks in order and stops at the first one we
+    // hold. While packets from an earlier block are still in the router,
+    // copy packets out of new blocks so that those go back at once.
+    int n = 0;
+    while (n < _burst) {
+	FromDeviceRing::Block *b = _ring->ready_block();
+	if (!b)
+	    break;
+	bool copy = _ring->_held.value() > 1;
+	tpacket_block_desc *desc = b->_desc;
+	unsigned char *frame = (unsigned char *) desc + desc->hdr.bh1.offset_to_first_pkt;
+	for (uint32_t i = desc->hdr.bh1.num_pkts; i > 0; i--) {
+	    tpacket3_hdr *h = (tpacket3_hdr *) frame;
+	    const sockaddr_ll *sa = (const sockaddr_ll *) (frame + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+	    frame += h->tp_next_offset;
+	    if (sa->sll_pkttype == PACKET_OUTGOING && !_outbound)
+		continue;
+
+	    uint32_t len = h->tp_snaplen;
+	    if (len > (uint32_t) _snaplen)
+		len = _snaplen;
+	    WritablePacket *p;
+	    if (copy)
+		p = Packet::make(_headroom, (unsigned char *) h + h->tp_mac, len, 0);
+	    else {
+		// the frame header becomes headroom
+		b->_refs++;
+		p = Packet::make((unsigned char *) h, h->tp_mac + len,
+				 FromDeviceRing::release_frame, b);
+		if (p)
+		    p->pull(h->tp_mac);
+		else
+		    _ring->release(b);
+	    }
+	    if (!p)
+		continue;
+
+	    if (h->tp_len > len)
+		SET_EXTRA_LENGTH_ANNO(p, h->tp_len - len);
+	    p->set_packet_type_anno((Packet::PacketType) sa->sll_pkttype);
+	    if (_timestamp)
+		p->timestamp_anno() = Timestamp::make_nsec(h->tp_sec, h->tp_nsec);
+	    p->set_mac_header(p->data());
+	    ++n;
+	    ++_count;
+	    if (!_force_ip || fake_pcap_force_ip(p, _datalink))
+		output(0).push(p);
+	    else
+		checked_output_push(1, p);
+	}
+	_ring->release(b);
+    }
+    return n;
+}
+#endif /* FROMDEVICE_ALLOW_MMAP */
+
+void
+FromDevice::run_timer(Timer *)
+{
+    // resume polling, see selected()
+    if (_fd >= 0)
+	add_select(_fd, SELECT_READ);
+}
 #endif /* FROMDEVICE_ALLOW_LINUX */
 
 #if FROMDEVICE_ALLOW_PCAP
@@ -357,7 +560,8 @@ FromDevice::initialize(ErrorHandler *errh)
 #endif
 
 #if FROMDEVICE_ALLOW_LINUX
-    if (_method == method_default || _method == method_linux) {
+    if (_method == method_default || _method == method_linux
+	|| _method == method_mmap) {
 	_fd = open_packet_socket(_ifname, errh);
 	if (_fd < 0)
 	    return -1;
@@ -371,7 +575,12 @@ FromDevice::initialize(ErrorHandler *errh)
 	    _was_promisc = promisc_ok;
 
 	_datalink = FAKE_DLT_EN10MB;
-	_method = method_linux;
+# if FROMDEVICE_ALLOW_MMAP
+	if (_method == method_mmap && open_ring(errh) < 0)
+	    return -1;
+# endif
+	if (_method != method_mmap)
+	    _method = method_linux;
     }
 #endif
 
@@ -401,12 +610,18 @@ FromDevice::cleanup(CleanupStage stage)
 	_netmap.close(_fd);
 #endif
 #if FROMDEVICE_ALLOW_LINUX
-    if (_fd >= 0 && _method == method_linux) {
+    if (_fd >= 0 && (_method == method_linux || _method == method_mmap)) {
 	if (_was_promisc >= 0)
 	    set_promiscuous(_fd, _ifname, _was_promisc);
 	close(_fd);
     }
 #endif
+#if FROMDEVICE_ALLOW_MMAP
+    // packets still in the router keep the ring mapped
+    if (_ring)
+	_ring->unref();
+    _ring = 0;
+#endif
 #if FROMDEVICE_ALLOW_PCAP
     if (_pcap)
 	pcap_close(_pcap);
@@ -489,6 +704,15 @@ FromDevice::selected(int, int)
 	    ErrorHandler::default_handler()->error("%p{element}: %s", this, pcap_geterr(_pcap));
     }
 #endif
+#if FROMDEVICE_ALLOW_MMAP
+    // The socket polls readable while the block before the one the kernel
+    // is filling belongs to us. If packets in the router still hold it
+    // there is nothing to read; back off instead of spinning.
+    if (_method == method_mmap && ring_dispatch() == 0 && _ring->_held.value()) {
+	remove_select(_fd, SELECT_READ);
+	_ring_timer.schedule_after_msec(1);
+    }
+#endif
 #if FROMDEVICE_ALLOW_LINUX
     int nlinux = 0;
     while (_method == method_linux && nlinux < _burst) {
@@ -561,6 +785,17 @@ FromDevice::kernel_drops(bool& known, int& max_drops) const
     // but for now, we just give up.
 #endif
     known = false, max_drops = -1;
+#if FROMDEVICE_ALLOW_MMAP
+    if (_method == method_mmap && _ring) {
+	// the kernel resets its counters on every read
+	struct tpacket_stats_v3 stats;
+	socklen_t len = sizeof(stats);
+	if (getsockopt(_fd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) >= 0) {
+	    _ring->_drops += stats.tp_drops;
+	    known = true, max_drops = _ring->_drops;
+	}
+    }
+#endif
 #if FROMDEVICE_ALLOW_PCAP
     if (_method == method_pcap) {
 	struct pcap_stat stats;
@@ -5,6 +5,7 @@
 
 #ifdef __linux__
 # define FROMDEVICE_ALLOW_LINUX 1
+# include <click/timer.hh>
 #endif
 
 #if HAVE_PCAP
@@ -93,8 +94,19 @@ but the IP header annotation has been set appropriately.) Default is false.
 =item METHOD
 
 Word.  Defines the capture method FromDevice will use to read packets from the
-device.  Linux targets generally support PCAP and LINUX; other targets support
-only PCAP.  Defaults to PCAP.
+device.  Linux targets generally support PCAP, LINUX and MMAP; other targets
+support only PCAP.  Defaults to PCAP.
+
+MMAP reads packets from a TPACKET_V3 ring shared with the kernel.  The kernel
+fills the ring one block at a time and FromDevice wakes up once per block, so
+that a single poll covers many packets.  Packets are not copied: they point
+into the ring, and a block is returned to the kernel when every packet taken
+from it has been freed.  The kernel fills the blocks in order and drops
+packets when it reaches a block that is still held, so while packets from
+one block are still in the router, FromDevice copies the packets of the
+following blocks.  A packet held for as long as it takes the kernel to go
+around the ring (for example, in a Queue that is not drained) still makes it
+drop packets.
 
 =item BPF_FILTER
 
@@ -126,6 +138,20 @@ Integer. Maximum number of packets to read per scheduling. Defaults to 1.
 
 Boolean. If false, then do not timestamp packets. Defaults to true.
 
+=item BLOCK_SIZE
+
+Unsigned. Size in bytes of a ring block for METHOD MMAP; must be a multiple of
+the page size. Defaults to 262144.
+
+=item BLOCKS
+
+Unsigned. Number of ring blocks for METHOD MMAP. Defaults to 16.
+
+=item BLOCK_TIMEOUT
+
+Unsigned. With METHOD MMAP, the kernel hands a block over to FromDevice after
+BLOCK_TIMEOUT milliseconds even if it is not full. Defaults to 1.
+
 =back
 
 =e
@@ -147,7 +173,7 @@ Resets "count" to zero.
 =h kernel_drops read-only
 
 Returns the number of packets dropped by the kernel, probably due to memory
-constraints, before FromDevice could get them. This may be an integer; the
+constraints or a full ring, before FromDevice could get them. This may be an integer; the
 notation C<"<I<d>">, meaning at most C<I<d>> drops; or C<"??">, meaning the
 number of drops is not known.
 
@@ -190,9 +216,12 @@ class FromDevice : public Element { public:
 #endif
 
 #if FROMDEVICE_ALLOW_LINUX
-    int linux_fd() const		{ return _method == method_linux ? _fd : -1; }
+    int linux_fd() const {
+	return _method == method_linux || _method == method_mmap ? _fd : -1;
+    }
     static int open_packet_socket(String, ErrorHandler *);
     static int set_promiscuous(int, String, bool);
+    void run_timer(Timer *);
 #endif
 
 #if FROMDEVICE_ALLOW_NETMAP
@@ -215,6 +244,13 @@ class FromDevice : public Element { public:
 #endif
 #if FROMDEVICE_ALLOW_LINUX
     unsigned char *_linux_packetbuf;
+    class FromDeviceRing *_ring;
+    unsigned _ring_block_size;
+    unsigned _ring_blocks;
+    unsigned _ring_timeout;
+    Timer _ring_timer;
+    int open_ring(ErrorHandler *);
+    int ring_dispatch();
 #endif
 #if FROMDEVICE_ALLOW_PCAP || FROMDEVICE_ALLOW_NETMAP
     void emit_packet(WritablePacket *p, int extra_len, const Timestamp &ts);
@@ -252,7 +288,8 @@ class FromDevice : public Element { public:
     int _was_promisc : 2;
     int _snaplen;
     unsigned _headroom;
-    enum { method_default, method_netmap, method_pcap, method_linux };
+    enum { method_default, method_netmap, method_pcap, method_linux,
+	   method_mmap };
     int _method;
 #if FROMDEVICE_ALLOW_PCAP
     String _bpf_filter;
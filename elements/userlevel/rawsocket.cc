@@ -43,12 +43,19 @@
 
 #include "fakepcap.hh"
 
+#if defined(__linux__) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 14))
+# define RAWSOCKET_ALLOW_MMSG 1
+#endif
+
 CLICK_DECLS
 
 RawSocket::RawSocket()
   : _task(this), _timer(this),
     _fd(-1), _port_register_socket(-1), _port(0), _snaplen(2048),
-    _headroom(Packet::default_headroom), _rq(0), _wq(0)
+    _headroom(Packet::default_headroom), _rq(0), _wq(0),
+    _burst(1), _rqs(0), _rmsg(0), _riov(0), _rctl(0),
+    _wqs(0), _wq_n(0), _wmsg(0), _wiov(0), _wto(0),
+    _rx_calls(0), _rx_packets(0), _tx_calls(0), _tx_packets(0)
 {
 }
 
@@ -69,9 +76,19 @@ RawSocket::configure(Vector<String> &conf, ErrorHandler *errh)
     args.read_p("PORT", _port);
   if (args.read("SNAPLEN", _snaplen)
       .read("HEADROOM", _headroom)
+      .read("BURST", _burst)
       .complete() < 0)
     return -1;
 
+  if (_burst < 1)
+    return errh->error("BURST must be at least 1");
+#if !RAWSOCKET_ALLOW_MMSG
+  if (_burst > 1) {
+    errh->warning("BURST ignored: recvmmsg() not supported on this platform");
+    _burst = 1;
+  }
+#endif
+
   return 0;
 }
 
@@ -94,6 +111,45 @@ RawSocket::initialize_socket_error(ErrorHandler *errh, const char *syscall)
   return errh->error("%s: %s", syscall, strerror(e));
 }
 
+int
+RawSocket::initialize_batch(ErrorHandler *errh)
+{
+#if RAWSOCKET_ALLOW_MMSG
+  // recvmmsg() returns all packets at once, so SIOCGSTAMP would only
+  // report the last one's time; ask for a timestamp with each packet
+  int one = 1;
+  if (noutputs() && setsockopt(_fd, SOL_SOCKET, SO_TIMESTAMP, &one, sizeof(one)) < 0)
+    return initialize_socket_error(errh, "SO_TIMESTAMP");
+
+  int ctllen = CMSG_SPACE(sizeof(struct timeval));
+  _rqs = new WritablePacket *[_burst];
+  _rmsg = new struct mmsghdr[_burst];
+  _riov = new struct iovec[_burst];
+  _rctl = new char[ctllen * _burst];
+  _wqs = new Packet *[_burst];
+  _wmsg = new struct mmsghdr[_burst];
+  _wiov = new struct iovec[_burst];
+  _wto = new struct sockaddr_in[_burst];
+  memset(_rmsg, 0, sizeof(struct mmsghdr) * _burst);
+  memset(_wmsg, 0, sizeof(struct mmsghdr) * _burst);
+  memset(_wto, 0, sizeof(struct sockaddr_in) * _burst);
+  for (int i = 0; i < _burst; ++i) {
+    _rqs[i] = 0;
+    _rmsg[i].msg_hdr.msg_iov = &_riov[i];
+    _rmsg[i].msg_hdr.msg_iovlen = 1;
+    _rmsg[i].msg_hdr.msg_control = _rctl + ctllen * i;
+    _wmsg[i].msg_hdr.msg_iov = &_wiov[i];
+    _wmsg[i].msg_hdr.msg_iovlen = 1;
+    _wmsg[i].msg_hdr.msg_name = &_wto[i];
+    _wmsg[i].msg_hdr.msg_namelen = sizeof(_wto[i]);
+    _wto[i].sin_family = PF_INET;
+  }
+#else
+  (void) errh;
+#endif
+  return 0;
+}
+
 int
 RawSocket::initialize(ErrorHandler *errh)
 {
@@ -141,6 +197,9 @@ RawSocket::initialize(ErrorHandler *errh)
   if (setsockopt(_fd, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one)) < 0)
     return initialize_socket_error(errh, "SO_BROADCAST");
 
+  if (_burst > 1 && initialize_batch(errh) < 0)
+    return -1;
+
   if (noutputs())
     add_select(_fd, SELECT_READ);
 
@@ -160,6 +219,27 @@ RawSocket::cleanup(CleanupStage)
     _rq->kill();
   if (_wq)
     _wq->kill();
+  if (_rqs)
+    for (int i = 0; i < _burst; ++i)
+      if (_rqs[i])
+	_rqs[i]->kill();
+  for (int i = 0; i < _wq_n; ++i)
+    _wqs[i]->kill();
+  _wq_n = 0;
+  delete[] _rqs;
+  delete[] _rmsg;
+  delete[] _riov;
+  delete[] _rctl;
+  delete[] _wqs;
+  delete[] _wmsg;
+  delete[] _wiov;
+  delete[] _wto;
+  _rqs = 0;
+  _rmsg = _wmsg = 0;
+  _riov = _wiov = 0;
+  _rctl = 0;
+  _wqs = 0;
+  _wto = 0;
   if (_fd >= 0) {
     close(_fd);
     remove_select(_fd, SELECT_READ | SELECT_WRITE);
@@ -167,13 +247,131 @@ RawSocket::cleanup(CleanupStage)
   }
 }
 
+void
+RawSocket::backoff()
+{
+  remove_select(_fd, SELECT_WRITE);
+  _events &= ~SELECT_WRITE;
+  _backoff = (!_backoff) ? 1 : _backoff*2;
+  _timer.schedule_after(Timestamp::make_usec(_backoff));
+}
+
+// Receive up to _burst packets with one recvmmsg().
+void
+RawSocket::read_batch()
+{
+#if RAWSOCKET_ALLOW_MMSG
+  int n = 0;
+  for (; n < _burst; ++n) {
+    if (!_rqs[n] && !(_rqs[n] = Packet::make(_headroom, (const unsigned char *)0, _snaplen, 0)))
+      break;
+    _riov[n].iov_base = _rqs[n]->data();
+    _riov[n].iov_len = _rqs[n]->length();
+    _rmsg[n].msg_hdr.msg_controllen = CMSG_SPACE(sizeof(struct timeval));
+  }
+  if (!n)
+    return;
+
+  n = recvmmsg(_fd, _rmsg, n, MSG_TRUNC, 0);
+  if (n < 0) {
+    if (errno != EAGAIN)
+      ErrorHandler::default_handler()->error("recvmmsg: %s", strerror(errno));
+    return;
+  }
+
+  ++_rx_calls;
+  for (int i = 0; i < n; ++i) {
+    WritablePacket *q = _rqs[i];
+    int len = _rmsg[i].msg_len;
+    _rqs[i] = 0;
+    if (len > _snaplen) {
+      assert(q->length() == (uint32_t)_snaplen);
+      SET_EXTRA_LENGTH_ANNO(q, len - _snaplen);
+    } else
+      q->take(_snaplen - len);
+    // set timestamp
+    struct msghdr *mh = &_rmsg[i].msg_hdr;
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(mh); c; c = CMSG_NXTHDR(mh, c))
+      if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMP) {
+	struct timeval tv;
+	memcpy(&tv, CMSG_DATA(c), sizeof(tv));
+	q->timestamp_anno() = Timestamp(tv);
+      }
+    // set IP annotations
+    ++_rx_packets;
+    if (fake_pcap_force_ip(q, FAKE_DLT_RAW))
+      output(0).push(q);
+    else
+      q->kill();
+  }
+#endif
+}
+
+// Send pulled packets in a batch of up to _burst with sendmmsg().
+// Returns the number of packets disposed of, 0 if there was nothing to
+// send, or -1 if the socket would block; unsent packets stay in _wqs.
+int
+RawSocket::write_batch()
+{
+#if RAWSOCKET_ALLOW_MMSG
+  while (_wq_n < _burst) {
+    Packet *p = input(0).pull();
+    if (!p)
+      break;
+    // cast to int so very large plen is interpreted as negative
+    if ((int)p->length() < (int)sizeof(click_ip)) {
+      ErrorHandler::default_handler()->error("runt IP packet (%d bytes)", p->length());
+      p->kill();
+      continue;
+    }
+    _wqs[_wq_n++] = p;
+  }
+  if (!_wq_n)
+    return 0;
+
+  for (int i = 0; i < _wq_n; ++i) {
+    Packet *p = _wqs[i];
+    _wiov[i].iov_base = const_cast<unsigned char *>(p->data());
+    _wiov[i].iov_len = p->length();
+    _wto[i].sin_addr = reinterpret_cast<const click_ip *>(p->data())->ip_dst;
+  }
+
+  int n;
+  do {
+    n = sendmmsg(_fd, _wmsg, _wq_n, 0);
+  } while (n < 0 && errno == EINTR);
+
+  if (n < 0) {
+    // socket queue full, try again later
+    if (errno == ENOBUFS || errno == EAGAIN)
+      return -1;
+    // unexpected error: drop packet
+    ErrorHandler::default_handler()->error("sendmmsg: %s", strerror(errno));
+    n = 1;
+  } else {
+    ++_tx_calls;
+    _tx_packets += n;
+  }
+
+  for (int i = 0; i < n; ++i)
+    _wqs[i]->kill();
+  _wq_n -= n;
+  memmove(_wqs, _wqs + n, _wq_n * sizeof(Packet *));
+  return n;
+#else
+  return 0;
+#endif
+}
+
 void
 RawSocket::selected(int fd, int)
 {
   ErrorHandler *errh = ErrorHandler::default_handler();
   int len;
 
-  if (noutputs()) {
+  if (noutputs() && _rqs)
+    read_batch();
+  else if (noutputs()) {
     // read data from socket
     if (!_rq)
       _rq = Packet::make(_headroom, (const unsigned char *)0, _snaplen, 0);
@@ -187,6 +385,8 @@ RawSocket::selected(int fd, int)
 	  _rq->take(_snaplen - len);
 	// set timestamp
 	(void) ioctl(fd, SIOCGSTAMP, &_rq->timestamp_anno());
+	++_rx_calls;
+	++_rx_packets;
 	// set IP annotations
 	if (fake_pcap_force_ip(_rq, FAKE_DLT_RAW))
 	  output(0).push(_rq);
@@ -202,7 +402,20 @@ RawSocket::selected(int fd, int)
     }
   }
 
-  if (ninputs()) {
+  if (ninputs() && _wqs) {
+    int n = write_batch();
+    if (n < 0) {
+      backoff();
+      return;
+    } else if (n > 0)
+      _backoff = 0;
+
+    // nothing to write, wait for upstream signal
+    if (!n && !_signal && (_events & SELECT_WRITE)) {
+      remove_select(_fd, SELECT_WRITE);
+      _events &= ~SELECT_WRITE;
+    }
+  } else if (ninputs()) {
     // write data to socket
     Packet *p;
     if (_wq) {
@@ -233,10 +446,7 @@ RawSocket::selected(int fd, int)
 	    if (errno == ENOBUFS || errno == EAGAIN) {
 	      // socket queue full, try again later
 	      _wq = p;
-	      remove_select(_fd, SELECT_WRITE);
-	      _events &= ~SELECT_WRITE;
-	      _backoff = (!_backoff) ? 1 : _backoff*2;
-	      _timer.schedule_after(Timestamp::make_usec(_backoff));
+	      backoff();
 	      return;
 	    } else if (errno == EINTR) {
 	      // interrupted by signal, try again immediately
@@ -250,6 +460,8 @@ RawSocket::selected(int fd, int)
 	    p->pull(len);
 	  }
 	}
+	++_tx_calls;
+	++_tx_packets;
 	_backoff = 0;
 	p->kill();
       }
@@ -266,7 +478,7 @@ RawSocket::selected(int fd, int)
 void
 RawSocket::run_timer(Timer *)
 {
-  if ((_wq || _signal) && !(_events & SELECT_WRITE) && _fd >= 0) {
+  if ((_wq || _wq_n || _signal) && !(_events & SELECT_WRITE) && _fd >= 0) {
     add_select(_fd, SELECT_WRITE);
     _events |= SELECT_WRITE;
     selected(_fd, 0);
@@ -276,7 +488,7 @@ RawSocket::run_timer(Timer *)
 bool
 RawSocket::run_task(Task *)
 {
-  if (!_wq && !(_events & SELECT_WRITE) && _fd >= 0) {
+  if (!_wq && !_wq_n && !(_events & SELECT_WRITE) && _fd >= 0) {
     add_select(_fd, SELECT_WRITE);
     _events |= SELECT_WRITE;
     selected(_fd, 0);
@@ -285,10 +497,32 @@ RawSocket::run_task(Task *)
     return false;
 }
 
+String
+RawSocket::read_handler(Element *e, void *thunk)
+{
+  RawSocket *rs = static_cast<RawSocket *>(e);
+  switch ((uintptr_t) thunk) {
+  case h_rx_calls:
+    return String(rs->_rx_calls);
+  case h_rx_packets:
+    return String(rs->_rx_packets);
+  case h_tx_calls:
+    return String(rs->_tx_calls);
+  case h_tx_packets:
+    return String(rs->_tx_packets);
+  default:
+    return String();
+  }
+}
+
 void
 RawSocket::add_handlers()
 {
   add_task_handlers(&_task);
+  add_read_handler("rx_calls", read_handler, h_rx_calls);
+  add_read_handler("rx_packets", read_handler, h_rx_packets);
+  add_read_handler("tx_calls", read_handler, h_tx_calls);
+  add_read_handler("tx_packets", read_handler, h_tx_packets);
 }
 
 CLICK_ENDDECLS
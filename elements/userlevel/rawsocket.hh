@@ -47,8 +47,32 @@ by this element. This could be useful for encapsulation protocols
 which add headers to the packet, and can avoid expensive push
 operations later in the packet's life.
 
+=item BURST
+
+Integer. If greater than 1, RawSocket receives up to BURST packets per
+recvmmsg() system call into preallocated packets, and sends up to BURST
+pulled packets per sendmmsg() call. Packets the kernel does not accept
+stay queued, in order, and are retried after the usual backoff. Ignored
+on platforms without recvmmsg() and sendmmsg(). Default is 1.
+
 =back
 
+=h rx_calls read-only
+
+Returns the number of receive system calls that returned data.
+
+=h rx_packets read-only
+
+Returns the number of packets received.
+
+=h tx_calls read-only
+
+Returns the number of send system calls that sent data.
+
+=h tx_packets read-only
+
+Returns the number of packets sent.
+
 =e
 
   RawSocket(UDP, 53) -> ...
@@ -93,7 +117,31 @@ private:
   Packet *_wq;			// queue to store pulled packet for when sendto() blocks
   int _events;			// keeps track of the events for which select() is waiting
 
+  // batched I/O (BURST > 1)
+  int _burst;			// maximum packets per system call
+  WritablePacket **_rqs;	// preallocated receive packets
+  struct mmsghdr *_rmsg;	// recvmmsg() headers, one per _rqs entry
+  struct iovec *_riov;
+  char *_rctl;			// control buffers for SCM_TIMESTAMP
+  Packet **_wqs;		// pulled packets not yet accepted by sendmmsg()
+  int _wq_n;
+  struct mmsghdr *_wmsg;	// sendmmsg() headers, one per _wqs entry
+  struct iovec *_wiov;
+  struct sockaddr_in *_wto;	// destination of each _wqs entry
+
+  uint64_t _rx_calls;		// receive calls that returned data
+  uint64_t _rx_packets;
+  uint64_t _tx_calls;		// send calls that sent data
+  uint64_t _tx_packets;
+
+  enum { h_rx_calls, h_rx_packets, h_tx_calls, h_tx_packets };
+
   int initialize_socket_error(ErrorHandler *, const char *);
+  int initialize_batch(ErrorHandler *);
+  void read_batch();
+  int write_batch();
+  void backoff();
+  static String read_handler(Element *, void *) CLICK_COLD;
 
 };
 
@@ -37,6 +37,10 @@
 #include <proper/prop.h>
 #endif
 
+#if defined(__linux__) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 14))
+# define SOCKET_ALLOW_MMSG 1
+#endif
+
 CLICK_DECLS
 
 Socket::Socket()
@@ -45,7 +49,10 @@ Socket::Socket()
     _local_port(0), _local_pathname(""),
     _timestamp(true), _sndbuf(-1), _rcvbuf(-1),
     _snaplen(2048), _headroom(Packet::default_headroom), _nodelay(1),
-    _verbose(false), _client(false), _proper(false), _allow(0), _deny(0)
+    _verbose(false), _client(false), _proper(false), _allow(0), _deny(0),
+    _burst(1), _rqs(0), _rmsg(0), _riov(0), _rfrom(0),
+    _wqs(0), _wq_n(0), _wmsg(0), _wiov(0), _wto(0),
+    _rx_calls(0), _rx_packets(0), _tx_calls(0), _tx_packets(0)
 {
 }
 
@@ -76,9 +83,13 @@ Socket::configure(Vector<String> &conf, ErrorHandler *errh)
       .read("PROPER", _proper)
       .read("ALLOW", allow)
       .read("DENY", deny)
+      .read("BURST", _burst)
       .consume() < 0)
     return -1;
 
+  if (_burst < 1)
+    return errh->error("BURST must be at least 1");
+
   if (allow && !(_allow = (IPRouteTable *)allow->cast("IPRouteTable")))
     return errh->error("%s is not an IPRouteTable", allow->name().c_str());
 
@@ -119,6 +130,15 @@ Socket::configure(Vector<String> &conf, ErrorHandler *errh)
   else
     return errh->error("unknown socket type `%s'", socktype.c_str());
 
+  if (_socktype != SOCK_DGRAM)
+    _burst = 1;
+#if !SOCKET_ALLOW_MMSG
+  if (_burst > 1) {
+    errh->warning("BURST ignored: recvmmsg() not supported on this platform");
+    _burst = 1;
+  }
+#endif
+
   return 0;
 }
 
@@ -137,6 +157,33 @@ Socket::initialize_socket_error(ErrorHandler *errh, const char *syscall)
   return errh->error("%s: %s", syscall, strerror(e));
 }
 
+int
+Socket::initialize_batch()
+{
+#if SOCKET_ALLOW_MMSG
+  _rqs = new WritablePacket *[_burst];
+  _rmsg = new struct mmsghdr[_burst];
+  _riov = new struct iovec[_burst];
+  _rfrom = new sockaddr_union[_burst];
+  _wqs = new Packet *[_burst];
+  _wmsg = new struct mmsghdr[_burst];
+  _wiov = new struct iovec[_burst];
+  _wto = new struct sockaddr_in[_burst];
+  memset(_rmsg, 0, sizeof(struct mmsghdr) * _burst);
+  memset(_wmsg, 0, sizeof(struct mmsghdr) * _burst);
+  for (int i = 0; i < _burst; ++i) {
+    _rqs[i] = 0;
+    _rmsg[i].msg_hdr.msg_iov = &_riov[i];
+    _rmsg[i].msg_hdr.msg_iovlen = 1;
+    if (!_client)
+      _rmsg[i].msg_hdr.msg_name = &_rfrom[i];
+    _wmsg[i].msg_hdr.msg_iov = &_wiov[i];
+    _wmsg[i].msg_hdr.msg_iovlen = 1;
+  }
+#endif
+  return 0;
+}
+
 int
 Socket::initialize(ErrorHandler *errh)
 {
@@ -252,6 +299,9 @@ Socket::initialize(ErrorHandler *errh)
   fcntl(_fd, F_SETFL, O_NONBLOCK);
   fcntl(_fd, F_SETFD, FD_CLOEXEC);
 
+  if (_burst > 1)
+    initialize_batch();
+
   if (noutputs())
     add_select(_fd, SELECT_READ);
 
@@ -276,6 +326,27 @@ Socket::cleanup(CleanupStage)
     _rq->kill();
   if (_wq)
     _wq->kill();
+  if (_rqs)
+    for (int i = 0; i < _burst; ++i)
+      if (_rqs[i])
+	_rqs[i]->kill();
+  for (int i = 0; i < _wq_n; ++i)
+    _wqs[i]->kill();
+  _wq_n = 0;
+  delete[] _rqs;
+  delete[] _rmsg;
+  delete[] _riov;
+  delete[] _rfrom;
+  delete[] _wqs;
+  delete[] _wmsg;
+  delete[] _wiov;
+  delete[] _wto;
+  _rqs = 0;
+  _rmsg = _wmsg = 0;
+  _riov = _wiov = 0;
+  _rfrom = 0;
+  _wqs = 0;
+  _wto = 0;
   if (_fd >= 0) {
     // shut down the listening socket in case we forked
 #ifdef SHUT_RDWR
@@ -360,9 +431,12 @@ Socket::selected(int fd, int)
     }
 
     // read data from socket
-    if (!_rq)
+    if (_rqs) {
+      if (selected_batch() < 0)
+	return;
+    } else if (!_rq)
       _rq = Packet::make(_headroom, 0, _snaplen, 0);
-    if (_rq) {
+    if (_rq && !_rqs) {
       if (_socktype == SOCK_STREAM)
 	len = read(_active, _rq->data(), _rq->length());
       else if (_client)
@@ -399,6 +473,8 @@ Socket::selected(int fd, int)
 	  _rq->timestamp_anno().assign_now();
 
 	// push packet
+	++_rx_calls;
+	++_rx_packets;
 	output(0).push(_rq);
 	_rq = 0;
       }
@@ -417,6 +493,135 @@ Socket::selected(int fd, int)
     run_task(0);
 }
 
+// Receive up to _burst datagrams with one recvmmsg().  Returns -1 if the
+// socket was closed because of an error.
+int
+Socket::selected_batch()
+{
+#if SOCKET_ALLOW_MMSG
+  int n = 0;
+  for (; n < _burst; ++n) {
+    if (!_rqs[n] && !(_rqs[n] = Packet::make(_headroom, 0, _snaplen, 0)))
+      break;
+    _riov[n].iov_base = _rqs[n]->data();
+    _riov[n].iov_len = _rqs[n]->length();
+    if (!_client)
+      _rmsg[n].msg_hdr.msg_namelen = sizeof(sockaddr_union);
+  }
+  if (!n)
+    return 0;
+
+  n = recvmmsg(_active, _rmsg, n, MSG_TRUNC, 0);
+  if (n < 0) {
+    if (errno == EAGAIN)
+      return 0;
+    if (_verbose)
+      click_chatter("%s: %s", declaration().c_str(), strerror(errno));
+    close_active();
+    return -1;
+  }
+
+  ++_rx_calls;
+  Timestamp now;
+  if (_timestamp)
+    now.assign_now();
+  for (int i = 0; i < n; ++i) {
+    WritablePacket *q = _rqs[i];
+    int len = _rmsg[i].msg_len;
+
+    if (!_client) {
+      sockaddr_union *from = &_rfrom[i];
+      if (_family == AF_INET && !allowed(IPAddress(from->in.sin_addr))) {
+	// leave the packet in place for the next call
+	if (_verbose)
+	  click_chatter("%s: dropped datagram from %s:%d", declaration().c_str(),
+			IPAddress(from->in.sin_addr).unparse().c_str(), ntohs(from->in.sin_port));
+	continue;
+      }
+      memcpy(&_remote, from, _rmsg[i].msg_hdr.msg_namelen);
+      _remote_len = _rmsg[i].msg_hdr.msg_namelen;
+    }
+
+    if (len > _snaplen) {
+      assert(q->length() == (uint32_t)_snaplen);
+      SET_EXTRA_LENGTH_ANNO(q, len - _snaplen);
+    } else
+      q->take(_snaplen - len);
+    if (_timestamp)
+      q->timestamp_anno() = now;
+
+    _rqs[i] = 0;
+    ++_rx_packets;
+    output(0).push(q);
+  }
+#endif
+  return 0;
+}
+
+// Send pulled packets in batches of up to _burst with sendmmsg().
+// Returns the number of packets disposed of, 0 if there was nothing to
+// send, or -1 if the socket would block; unsent packets stay in _wqs.
+int
+Socket::write_batch()
+{
+#if SOCKET_ALLOW_MMSG
+  while (_wq_n < _burst) {
+    Packet *p = input(0).pull();
+    if (!p)
+      break;
+    _wqs[_wq_n++] = p;
+  }
+  if (!_wq_n)
+    return 0;
+
+  // If the IP address specified when the element was created is 0.0.0.0,
+  // send each packet to its IP destination annotation address
+  bool anno_dst = !IPAddress(_remote_ip) && _client && _family == AF_INET;
+  for (int i = 0; i < _wq_n; ++i) {
+    Packet *p = _wqs[i];
+    _wiov[i].iov_base = const_cast<unsigned char *>(p->data());
+    _wiov[i].iov_len = p->length();
+    if (anno_dst) {
+      _wto[i] = _remote.in;
+      _wto[i].sin_addr = p->dst_ip_anno();
+      _wmsg[i].msg_hdr.msg_name = &_wto[i];
+      _wmsg[i].msg_hdr.msg_namelen = sizeof(_wto[i]);
+    } else {
+      _wmsg[i].msg_hdr.msg_name = &_remote;
+      _wmsg[i].msg_hdr.msg_namelen = _remote_len;
+    }
+  }
+
+  int n;
+  do {
+    n = sendmmsg(_active, _wmsg, _wq_n, 0);
+  } while (n < 0 && errno == EINTR);
+
+  if (n < 0) {
+    // out of memory or would block
+    if (errno == ENOBUFS || errno == EAGAIN)
+      return -1;
+    // connection probably terminated or other fatal error; drop the
+    // packet that failed
+    if (_verbose)
+      click_chatter("%s: %s", declaration().c_str(), strerror(errno));
+    close_active();
+    n = 1;
+  } else {
+    ++_tx_calls;
+    _tx_packets += n;
+  }
+
+  for (int i = 0; i < n; ++i)
+    _wqs[i]->kill();
+  _wq_n -= n;
+  memmove(_wqs, _wqs + n, _wq_n * sizeof(Packet *));
+  return n;
+#else
+  return 0;
+#endif
+}
+
 int
 Socket::write_packet(Packet *p)
 {
@@ -501,25 +706,40 @@ Socket::run_task(Task *)
   bool any = false;
 
   if (_active >= 0) {
-    Packet *p = 0;
     int err = 0;
 
-    // write as much as we can
-    do {
-      p = _wq ? _wq : input(0).pull();
-      _wq = 0;
-      if (p) {
+    if (_wqs) {
+      // write batches until the socket blocks or upstream runs dry; a
+      // short batch leaves its tail in _wqs for the next round
+      while ((err = write_batch()) > 0 && _active >= 0)
 	any = true;
-	err = write_packet(p);
-      }
-    } while (p && err >= 0);
+      if (_active < 0)
+	return any;
+    } else {
+      Packet *p = 0;
+
+      // write as much as we can
+      do {
+	p = _wq ? _wq : input(0).pull();
+	_wq = 0;
+	if (p) {
+	  any = true;
+	  err = write_packet(p);
+	  if (err >= 0) {
+	    ++_tx_calls;
+	    ++_tx_packets;
+	  }
+	}
+      } while (p && err >= 0);
 
-    if (err < 0) {
       // queue packet for writing when socket becomes available
-      _wq = p;
-      p = 0;
+      if (err < 0)
+	_wq = p;
+    }
+
+    if (err < 0)
       add_select(_active, SELECT_WRITE);
-    } else if (_signal)
+    else if (_signal)
       // more pending
       // (can't use fast_reschedule() cause selected() calls this)
       _task.reschedule();
@@ -532,10 +752,32 @@ Socket::run_task(Task *)
   return any;
 }
 
+String
+Socket::read_handler(Element *e, void *thunk)
+{
+  Socket *s = static_cast<Socket *>(e);
+  switch ((uintptr_t) thunk) {
+  case h_rx_calls:
+    return String(s->_rx_calls);
+  case h_rx_packets:
+    return String(s->_rx_packets);
+  case h_tx_calls:
+    return String(s->_tx_calls);
+  case h_tx_packets:
+    return String(s->_tx_packets);
+  default:
+    return String();
+  }
+}
+
 void
 Socket::add_handlers()
 {
   add_task_handlers(&_task);
+  add_read_handler("rx_calls", read_handler, h_rx_calls);
+  add_read_handler("rx_packets", read_handler, h_rx_packets);
+  add_read_handler("tx_calls", read_handler, h_tx_calls);
+  add_read_handler("tx_packets", read_handler, h_tx_packets);
 }
 
 CLICK_ENDDECLS
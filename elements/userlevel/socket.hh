@@ -142,8 +142,34 @@ Boolean. PlanetLab specific. If true and Click has been configured
 
 Integer. Per-packet headroom. Defaults to 28.
 
+=item BURST
+
+Integer. Applies to UDP and UNIX_DGRAM sockets only. If greater than 1,
+Socket receives up to BURST datagrams per recvmmsg() system call into
+preallocated packets, and a "pull" Socket sends up to BURST pulled
+packets per sendmmsg() call. Datagrams the kernel does not accept stay
+queued, in order, until the socket is writable again. "Push" inputs
+always send one packet at a time. Ignored on platforms without
+recvmmsg() and sendmmsg(). Default is 1.
+
 =back
 
+=h rx_calls read-only
+
+Returns the number of receive system calls that returned data.
+
+=h rx_packets read-only
+
+Returns the number of datagrams or segments received.
+
+=h tx_calls read-only
+
+Returns the number of send system calls made for pulled packets.
+
+=h tx_packets read-only
+
+Returns the number of pulled packets sent.
+
 =e
 
   // A server socket
@@ -193,6 +219,7 @@ class Socket : public Element { public:
   bool allowed(IPAddress);
   void close_active(void);
   int write_packet(Packet*);
+  int write_batch();
 
 protected:
   Task _task;
@@ -239,7 +266,30 @@ private:
   IPRouteTable *_allow;		// lookup table of good hosts
   IPRouteTable *_deny;		// lookup table of bad hosts
 
+  // batched datagram I/O (BURST > 1)
+  union sockaddr_union { struct sockaddr_in in; struct sockaddr_un un; };
+  int _burst;			// maximum datagrams per system call
+  WritablePacket **_rqs;	// preallocated receive packets
+  struct mmsghdr *_rmsg;	// recvmmsg() headers, one per _rqs entry
+  struct iovec *_riov;
+  sockaddr_union *_rfrom;	// source address of each received datagram
+  Packet **_wqs;		// pulled packets not yet accepted by sendmmsg()
+  int _wq_n;
+  struct mmsghdr *_wmsg;	// sendmmsg() headers, one per _wqs entry
+  struct iovec *_wiov;
+  struct sockaddr_in *_wto;	// per-packet destinations for zero-IP clients
+
+  uint64_t _rx_calls;		// receive calls that returned data
+  uint64_t _rx_packets;
+  uint64_t _tx_calls;		// send calls for pulled packets
+  uint64_t _tx_packets;
+
+  enum { h_rx_calls, h_rx_packets, h_tx_calls, h_tx_packets };
+
   int initialize_socket_error(ErrorHandler *, const char *);
+  int initialize_batch();
+  int selected_batch();
+  static String read_handler(Element *, void *) CLICK_COLD;
 
 };
 
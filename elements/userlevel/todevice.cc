@@ -53,6 +53,9 @@
 # else
 #  include <linux/if_packet.h>
 # endif
+# if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 14)
+#  define TODEVICE_ALLOW_SENDMMSG 1
+# endif
 #endif
 #if TODEVICE_ALLOW_NETMAP
 //# include <sys/mman.h>
@@ -71,6 +74,13 @@ ToDevice::ToDevice()
     _fd = -1;
     _my_fd = false;
 #endif
+#if TODEVICE_ALLOW_LINUX
+    _batch = false;
+    _bq_n = 0;
+    _bq = 0;
+    _mmsg = 0;
+    _iov = 0;
+#endif
 }
 
 ToDevice::~ToDevice()
@@ -81,18 +91,26 @@ int
 ToDevice::configure(Vector<String> &conf, ErrorHandler *errh)
 {
     String method;
+    bool batch = false;
     _burst = 1;
     if (Args(conf, this, errh)
 	.read_mp("DEVNAME", _ifname)
 	.read("DEBUG", _debug)
 	.read("METHOD", WordArg(), method)
 	.read("BURST", _burst)
+	.read("BATCH", batch)
 	.complete() < 0)
 	return -1;
     if (!_ifname)
 	return errh->error("interface not set");
     if (_burst <= 0)
 	return errh->error("bad BURST");
+#if TODEVICE_ALLOW_SENDMMSG
+    _batch = batch;
+#else
+    if (batch)
+	return errh->error("BATCH not supported on this platform");
+#endif
 
     if (method == "") {
 #if TODEVICE_ALLOW_PCAP || TODEVICE_ALLOW_PCAPFD || TODEVICE_ALLOW_LINUX || TODEVICE_ALLOW_DEVBPF || TODEVICE_ALLOW_NETMAP
@@ -234,6 +252,18 @@ ToDevice::initialize(ErrorHandler *errh)
 	}
 	_method = method_linux;
     }
+    if (_batch) {
+	if (_method != method_linux)
+	    return errh->error("BATCH requires METHOD LINUX");
+	_bq = new Packet *[_burst];
+	_mmsg = new struct mmsghdr[_burst];
+	_iov = new struct iovec[_burst];
+	memset(_mmsg, 0, sizeof(struct mmsghdr) * _burst);
+	for (int i = 0; i < _burst; ++i) {
+	    _mmsg[i].msg_hdr.msg_iov = &_iov[i];
+	    _mmsg[i].msg_hdr.msg_iovlen = 1;
+	}
+    }
 #endif
 
 #if TODEVICE_ALLOW_PCAPFD
@@ -277,6 +307,17 @@ ToDevice::cleanup(CleanupStage)
 	close(_fd);
     _fd = -1;
 #endif
+#if TODEVICE_ALLOW_LINUX
+    for (int i = 0; i < _bq_n; ++i)
+	_bq[i]->kill();
+    _bq_n = 0;
+    delete[] _bq;
+    delete[] _mmsg;
+    delete[] _iov;
+    _bq = 0;
+    _mmsg = 0;
+    _iov = 0;
+#endif
 }
 
 
@@ -339,9 +380,83 @@ ToDevice::send_packet(Packet *p)
 	return errno ? -errno : -EINVAL;
 }
 
+void
+ToDevice::backoff()
+{
+    if (!_backoff) {
+	_backoff = 1;
+	add_select(_fd, SELECT_WRITE);
+    } else {
+	_timer.schedule_after(Timestamp::make_usec(_backoff));
+	if (_backoff < 256)
+	    _backoff *= 2;
+	if (_debug) {
+	    Timestamp now = Timestamp::now();
+	    click_chatter("%p{element} backing off for %d at %p{timestamp}\n", this, _backoff, &now);
+	}
+    }
+}
+
+#if TODEVICE_ALLOW_SENDMMSG
+/*
+ * Batched version of run_task for METHOD LINUX: top the pending queue up
+ * to BURST packets and send them with one sendmmsg().  A short count
+ * means the kernel stopped at the first packet it could not take; that
+ * packet and the ones after it stay at the head of _bq, in order, and
+ * the next call reports its error.
+ */
+bool
+ToDevice::run_batch()
+{
+    while (_bq_n < _burst) {
+	++_pulls;
+	if (!(_bq[_bq_n] = input(0).pull()))
+	    break;
+	++_bq_n;
+    }
+    if (!_bq_n) {
+	if (_signal)
+	    _task.fast_reschedule();
+	return false;
+    }
+
+    for (int i = 0; i < _bq_n; ++i) {
+	_iov[i].iov_base = const_cast<unsigned char *>(_bq[i]->data());
+	_iov[i].iov_len = _bq[i]->length();
+    }
+    int count = sendmmsg(_fd, _mmsg, _bq_n, 0);
+
+    if (count > 0) {
+	_backoff = 0;
+	for (int i = 0; i < count; ++i)
+	    checked_output_push(0, _bq[i]);
+    } else {
+	int r = errno ? errno : EINVAL;
+	if (r == ENOBUFS || r == EAGAIN) {
+	    backoff();
+	    return false;
+	}
+	click_chatter("ToDevice(%s): %s", _ifname.c_str(), strerror(r));
+	checked_output_push(1, _bq[0]);
+    }
+    int done = count > 0 ? count : 1;
+    _bq_n -= done;
+    memmove(_bq, _bq + done, _bq_n * sizeof(Packet *));
+
+    if (_bq_n || _signal)
+	_task.fast_reschedule();
+    return count > 0;
+}
+#endif
+
 bool
 ToDevice::run_task(Task *)
 {
+#if TODEVICE_ALLOW_SENDMMSG
+    if (_batch)
+	return run_batch();
+#endif
+
     Packet *p = _q;
     _q = 0;
     int count = 0, r = 0;
@@ -364,19 +479,7 @@ ToDevice::run_task(Task *)
     if (r == -ENOBUFS || r == -EAGAIN) {
 	assert(!_q);
 	_q = p;
-
-	if (!_backoff) {
-	    _backoff = 1;
-	    add_select(_fd, SELECT_WRITE);
-	} else {
-	    _timer.schedule_after(Timestamp::make_usec(_backoff));
-	    if (_backoff < 256)
-		_backoff *= 2;
-	    if (_debug) {
-		Timestamp now = Timestamp::now();
-		click_chatter("%p{element} backing off for %d at %p{timestamp}\n", this, _backoff, &now);
-	    }
-	}
+	backoff();
 	return count > 0;
     } else if (r < 0) {
 	click_chatter("ToDevice(%s): %s", _ifname.c_str(), strerror(-r));
@@ -407,8 +510,13 @@ ToDevice::read_param(Element *e, void *thunk)
 	return String(td->_signal);
     case h_pulls:
 	return String(td->_pulls);
-    case h_q:
-	return String((bool) td->_q);
+    case h_q: {
+	bool q = td->_q;
+#if TODEVICE_ALLOW_LINUX
+	q = q || td->_bq_n;
+#endif
+	return String(q);
+    }
     default:
 	return String();
     }
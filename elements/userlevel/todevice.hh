@@ -30,6 +30,13 @@ CLICK_DECLS
  *
  * Integer. Maximum number of packets to pull per scheduling. Defaults to 1.
  *
+ * =item BATCH
+ *
+ * Boolean. If true and METHOD is LINUX, hand up to BURST packets to the
+ * kernel with a single sendmmsg() system call rather than one send() per
+ * packet. Packets the kernel does not accept stay queued, in order, and are
+ * retried when the device has room. Defaults to false.
+ *
  * =item METHOD
  *
  * Word. Defines the method ToDevice will use to write packets to the
@@ -126,6 +133,13 @@ class ToDevice : public Element { public:
 
     Packet *_q;
     int _burst;
+#if TODEVICE_ALLOW_LINUX
+    bool _batch;
+    int _bq_n;
+    Packet **_bq;
+    struct mmsghdr *_mmsg;
+    struct iovec *_iov;
+#endif
 
     bool _debug;
 #if TODEVICE_ALLOW_PCAP
@@ -140,6 +154,10 @@ class ToDevice : public Element { public:
     enum { h_debug, h_signal, h_pulls, h_q };
     FromDevice *find_fromdevice() const;
     int send_packet(Packet *p);
+    void backoff();
+#if TODEVICE_ALLOW_LINUX
+    bool run_batch();
+#endif
     static int write_param(const String &in_s, Element *e, void *vparam, ErrorHandler *errh) CLICK_COLD;
     static String read_param(Element *e, void *thunk) CLICK_COLD;
 
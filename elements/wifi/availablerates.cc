@@ -25,6 +25,7 @@
 CLICK_DECLS
 
 AvailableRates::AvailableRates()
+  : _version(1)
 {
 }
 
@@ -51,6 +52,7 @@ AvailableRates::parse_and_insert(String s, ErrorHandler *errh)
   if (args.size() < 2) {
     return errh->error("error param %s must have > 1 arg", s.c_str());
   }
+  _version++;
   bool default_rates = false;
   if (args[0] == "DEFAULT") {
     default_rates = true;
@@ -102,6 +104,7 @@ AvailableRates::take_state(Element *e, ErrorHandler *)
   if (!q) return;
   _rtable = q->_rtable;
   _default_rates = q->_default_rates;
+  _version++;
 
 }
 
@@ -142,7 +145,7 @@ AvailableRates::supported(EtherAddress eth)
 }
 
 int
-AvailableRates::insert(EtherAddress eth, Vector<int> rates)
+AvailableRates::insert(EtherAddress eth, const Vector<int> &rates)
 {
   if (!(eth)) {
     if (_debug) {
@@ -158,18 +161,31 @@ AvailableRates::insert(EtherAddress eth, Vector<int> rates)
     dst = _rtable.findp(eth);
   }
   dst->_eth = eth;
-  dst->_rates.clear();
-  if (_default_rates.size()) {
-    /* only add rates that are in the default rates */
-    for (int x = 0; x < rates.size(); x++) {
-      for (int y = 0; y < _default_rates.size(); y++) {
-	if (rates[x] == _default_rates[y]) {
-	  dst->_rates.push_back(rates[x]);
-	}
+  /* rewrite the rates in place, noting whether they changed */
+  int n = 0;
+  bool changed = false;
+  for (int x = 0; x < rates.size(); x++) {
+    for (int y = 0; y < (_default_rates.size() ? _default_rates.size() : 1); y++) {
+      /* only add rates that are in the default rates */
+      if (_default_rates.size() && rates[x] != _default_rates[y]) {
+	continue;
+      }
+      if (n == dst->_rates.size()) {
+	dst->_rates.push_back(rates[x]);
+	changed = true;
+      } else if (dst->_rates[n] != rates[x]) {
+	dst->_rates[n] = rates[x];
+	changed = true;
       }
+      n++;
     }
-  } else {
-    dst->_rates = rates;
+  }
+  if (n != dst->_rates.size()) {
+    dst->_rates.resize(n);
+    changed = true;
+  }
+  if (changed) {
+    _version++;
   }
   return 0;
 }
@@ -230,6 +246,7 @@ AvailableRates_write_param(const String &in_s, Element *e, void *vparam,
     if (!EtherAddressArg().parse(s, e))
       return errh->error("remove parameter must be ethernet address");
     f->_rtable.erase(e);
+    f->_version++;
     break;
   }
 
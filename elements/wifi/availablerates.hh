@@ -50,7 +50,10 @@ class AvailableRates : public Element { public:
 
   Vector<int> lookup(EtherAddress eth);
   Vector<int> supported(EtherAddress eth);
-  int insert(EtherAddress eth, Vector<int>);
+  int insert(EtherAddress eth, const Vector<int> &);
+
+  // changes whenever the rates of some station change
+  uint32_t version() const			{ return _version; }
 
   bool _debug;
 
@@ -75,6 +78,7 @@ class AvailableRates : public Element { public:
 
   RTable _rtable;
   Vector<int> _default_rates;
+  uint32_t _version;
 private:
 };
 
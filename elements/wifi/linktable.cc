@@ -156,6 +156,10 @@ void
 LinkTable::dijkstra(bool from_me)
 {
 
+  if (!dijkstra_needed(from_me)) {
+    return;
+  }
+
   typedef HashMap<IPAddress, bool> AddressMap;
   typedef AddressMap::const_iterator AMIter;
 
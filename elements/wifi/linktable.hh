@@ -56,6 +56,8 @@ public:
     return false;
   }
   virtual U best_route(T, bool) = 0;
+  const U &cached_route(T, bool);
+  uint32_t route_epoch() const { return _route_epoch; }
 
   virtual uint32_t get_route_metric(const U &) = 0;
 
@@ -67,6 +69,7 @@ public:
   bool valid_route(const U &);
   virtual void dijkstra(bool) = 0;
   void clear_stale();
+  void mark_dirty() { _dirty_from_me = _dirty_to_me = true; }
 
   uint32_t get_host_metric_to_me(T s);
   uint32_t get_host_metric_from_me(T s);
@@ -218,6 +221,58 @@ protected:
   HTable _hosts;
   LTable _links;
 
+  /* dense host index and adjacency lists mirroring _links, kept in
+   * sync by update_link() so that dijkstra() need not probe _links */
+  class LinkEdge {
+  public:
+    int _peer;
+    uint32_t _metric;
+    uint32_t _channel;
+    LinkEdge() : _peer(-1), _metric(0), _channel(0) { }
+    LinkEdge(int peer, uint32_t metric, uint32_t channel)
+      : _peer(peer), _metric(metric), _channel(channel) { }
+  };
+
+  typedef Vector<LinkEdge> EdgeList;
+
+  HashMap<T, int> _host_index;
+  Vector<T> _host_addrs;
+  Vector<EdgeList> _out_edges;
+  Vector<EdgeList> _in_edges;
+
+  int host_index(T);
+  LinkEdge *find_edge(EdgeList &, int);
+  void update_edges(const LinkInfo &);
+  void rebuild_adjacency();
+
+  /* route recomputation is skipped unless a link change could move the
+   * corresponding shortest path tree */
+  bool _dirty_from_me;
+  bool _dirty_to_me;
+  uint32_t _flap_threshold;
+  uint32_t _dijkstra_runs;
+  uint32_t _dijkstra_skipped;
+  uint32_t _damped_updates;
+
+  bool dijkstra_needed(bool);
+
+  /* best_route() results, valid while their epoch matches _route_epoch
+   * which is bumped every time the routes are recomputed */
+  class CachedRoute {
+  public:
+    uint32_t _epoch;
+    U _route;
+    CachedRoute() : _epoch(0) { }
+  };
+
+  typedef HashMap<T, CachedRoute> RouteCache;
+
+  RouteCache _routes_from_me;
+  RouteCache _routes_to_me;
+  uint32_t _route_epoch;
+  uint32_t _route_cache_hits;
+  uint32_t _route_cache_misses;
+
   T _ip;
   Timestamp _stale_timeout;
   Timer _timer;
@@ -230,7 +285,10 @@ protected:
 
 template <typename T, typename U>
 LinkTableBase<T,U>::LinkTableBase()
-  : _timer(this)
+  : _dirty_from_me(true), _dirty_to_me(true), _flap_threshold(0),
+    _dijkstra_runs(0), _dijkstra_skipped(0), _damped_updates(0),
+    _route_epoch(1), _route_cache_hits(0), _route_cache_misses(0),
+    _timer(this)
 {
 }
 
@@ -276,6 +334,8 @@ LinkTableBase<T,U>::take_state(Element *e, ErrorHandler *) {
 
   _hosts = q->_hosts;
   _links = q->_links;
+  rebuild_adjacency();
+  mark_dirty();
   dijkstra(true);
   dijkstra(false);
 }
@@ -286,7 +346,14 @@ LinkTableBase<T,U>::clear()
 {
   _hosts.clear();
   _links.clear();
-
+  _host_index.clear();
+  _host_addrs.clear();
+  _out_edges.clear();
+  _in_edges.clear();
+  _routes_from_me.clear();
+  _routes_to_me.clear();
+  _route_epoch++;
+  mark_dirty();
 }
 
 template <typename T, typename U>
@@ -319,12 +386,139 @@ LinkTableBase<T,U>::update_link(T from, T to, uint32_t seq, uint32_t age, uint32
   LinkInfo *lnfo = _links.findp(p);
   if (!lnfo) {
     _links.insert(p, LinkInfo(from, to, seq, age, metric, channel));
+    lnfo = _links.findp(p);
   } else {
     lnfo->update(seq, age, metric, channel);
   }
+
+  /* host_index() may grow _out_edges, so index it only afterwards */
+  int fi = host_index(from), ti = host_index(to);
+  LinkEdge *edge = find_edge(_out_edges[fi], ti);
+  if (edge && edge->_channel == lnfo->_channel) {
+    uint32_t old_metric = edge->_metric;
+    uint32_t delta = (lnfo->_metric > old_metric) ? lnfo->_metric - old_metric : old_metric - lnfo->_metric;
+    if (!delta) {
+      return true;
+    }
+    /* small changes are ignored and do not accumulate, the edge keeps
+     * the metric the current routes were computed with */
+    if ((uint64_t) delta * 100 < (uint64_t) old_metric * _flap_threshold) {
+      _damped_updates++;
+      return true;
+    }
+    /* a worse metric on a link outside a tree cannot change that tree */
+    if (lnfo->_metric < old_metric || nto->_prev_from_me == from) {
+      _dirty_from_me = true;
+    }
+    if (lnfo->_metric < old_metric || nfrom->_prev_to_me == to) {
+      _dirty_to_me = true;
+    }
+  } else {
+    mark_dirty();
+  }
+
+  update_edges(*lnfo);
   return true;
 }
 
+template <typename T, typename U>
+bool
+LinkTableBase<T,U>::dijkstra_needed(bool from_me)
+{
+  bool &dirty = from_me ? _dirty_from_me : _dirty_to_me;
+  if (!dirty) {
+    _dijkstra_skipped++;
+    return false;
+  }
+  dirty = false;
+  _dijkstra_runs++;
+  _route_epoch++;
+  return true;
+}
+
+template <typename T, typename U>
+const U &
+LinkTableBase<T,U>::cached_route(T dst, bool from_me)
+{
+  RouteCache &cache = from_me ? _routes_from_me : _routes_to_me;
+  CachedRoute *cr = cache.findp(dst);
+  if (cr && cr->_epoch == _route_epoch) {
+    _route_cache_hits++;
+    return cr->_route;
+  }
+  _route_cache_misses++;
+  if (!cr) {
+    cache.insert(dst, CachedRoute());
+    cr = cache.findp(dst);
+  }
+  cr->_route = best_route(dst, from_me);
+  cr->_epoch = _route_epoch;
+  return cr->_route;
+}
+
+template <typename T, typename U>
+int
+LinkTableBase<T,U>::host_index(T address)
+{
+  int *idx = _host_index.findp(address);
+  if (idx) {
+    return *idx;
+  }
+  int i = _host_addrs.size();
+  _host_index.insert(address, i);
+  _host_addrs.push_back(address);
+  _out_edges.push_back(EdgeList());
+  _in_edges.push_back(EdgeList());
+  return i;
+}
+
+template <typename T, typename U>
+typename LinkTableBase<T,U>::LinkEdge *
+LinkTableBase<T,U>::find_edge(EdgeList &edges, int peer)
+{
+  for (int x = 0; x < edges.size(); x++) {
+    if (edges[x]._peer == peer) {
+      return &edges[x];
+    }
+  }
+  return 0;
+}
+
+template <typename T, typename U>
+void
+LinkTableBase<T,U>::update_edges(const LinkInfo &nfo)
+{
+  int from = host_index(nfo._from);
+  int to = host_index(nfo._to);
+  LinkEdge *out = find_edge(_out_edges[from], to);
+  if (!out) {
+    _out_edges[from].push_back(LinkEdge(to, nfo._metric, nfo._channel));
+  } else {
+    out->_metric = nfo._metric;
+    out->_channel = nfo._channel;
+  }
+  LinkEdge *in = find_edge(_in_edges[to], from);
+  if (!in) {
+    _in_edges[to].push_back(LinkEdge(from, nfo._metric, nfo._channel));
+  } else {
+    in->_metric = nfo._metric;
+    in->_channel = nfo._channel;
+  }
+}
+
+template <typename T, typename U>
+void
+LinkTableBase<T,U>::rebuild_adjacency()
+{
+  _host_index.clear();
+  _host_addrs.clear();
+  _out_edges.clear();
+  _in_edges.clear();
+  for (LTIter iter = _links.begin(); iter.live(); iter++) {
+    update_edges(iter.value());
+  }
+}
+
 template <typename T, typename U>
 Vector<T>
 LinkTableBase<T,U>::get_hosts()
@@ -516,11 +710,16 @@ LinkTableBase<T,U>::clear_stale() {
       links.insert(AddressPair(nfo._from, nfo._to), nfo);
     }
   }
+  if (links.size() == _links.size()) {
+    return;
+  }
   _links.clear();
   for (LTIter iter = links.begin(); iter.live(); iter++) {
     LinkInfo nfo = iter.value();
     _links.insert(AddressPair(nfo._from, nfo._to), nfo);
   }
+  rebuild_adjacency();
+  mark_dirty();
 }
 
 enum {H_HOST_IP,
@@ -536,7 +735,11 @@ enum {H_HOST_IP,
       H_CLEAR,
       H_DIJKSTRA,
       H_UPDATE_LINK,
-      H_DIJKSTRA_TIME};
+      H_DIJKSTRA_TIME,
+      H_DIJKSTRA_RUNS,
+      H_DIJKSTRA_SKIPPED,
+      H_DAMPED_UPDATES,
+      H_ROUTE_CACHE};
 
 template <typename T, typename U>
 String 
@@ -561,6 +764,18 @@ LinkTableBase<T,U>::read_handler(Element *e, void *thunk) {
       sa << td->_dijkstra_time << "\n";
       return sa.take_string();
     }
+    case H_DIJKSTRA_RUNS: return String(td->_dijkstra_runs) + "\n";
+    case H_DIJKSTRA_SKIPPED: return String(td->_dijkstra_skipped) + "\n";
+    case H_DAMPED_UPDATES: return String(td->_damped_updates) + "\n";
+    case H_ROUTE_CACHE: {
+      StringAccum sa;
+      uint32_t lookups = td->_route_cache_hits + td->_route_cache_misses;
+      sa << "epoch " << td->_route_epoch;
+      sa << " hits " << td->_route_cache_hits;
+      sa << " misses " << td->_route_cache_misses;
+      sa << " hit_rate " << (lookups ? (uint32_t) (((uint64_t) td->_route_cache_hits * 100) / lookups) : 0) << "%\n";
+      return sa.take_string();
+    }
     default:
       return String();
     }
@@ -635,7 +850,7 @@ LinkTableBase<T,U>::write_handler(const String &in_s, Element *e, void *vparam,
     break;
   }
   case H_CLEAR: f->clear(); break;
-  case H_DIJKSTRA: f->dijkstra(true); f->dijkstra(false); break;
+  case H_DIJKSTRA: f->mark_dirty(); f->dijkstra(true); f->dijkstra(false); break;
   }
   return 0;
 }
@@ -652,6 +867,10 @@ LinkTableBase<T,U>::add_handlers() {
   add_read_handler("hosts", read_handler, H_HOSTS);
   add_read_handler("blacklist", read_handler, H_BLACKLIST);
   add_read_handler("dijkstra_time", read_handler, H_DIJKSTRA_TIME);
+  add_read_handler("dijkstra_runs", read_handler, H_DIJKSTRA_RUNS);
+  add_read_handler("dijkstra_skipped", read_handler, H_DIJKSTRA_SKIPPED);
+  add_read_handler("damped_updates", read_handler, H_DAMPED_UPDATES);
+  add_read_handler("route_cache", read_handler, H_ROUTE_CACHE);
   add_write_handler("clear", write_handler, H_CLEAR);
   add_write_handler("blacklist_clear", write_handler, H_BLACKLIST_CLEAR);
   add_write_handler("blacklist_add", write_handler, H_BLACKLIST_ADD);
@@ -30,78 +30,78 @@ CLICK_DECLS
 
 Minstrel::Minstrel() 
   : _rtable(0), _rtable_ht(0), _timer(this), _lookaround_rate(20), _offset(0), 
-_active(true), _period(500), _ewma_level(75), _debug(false) {
+_active(true), _period(500), _spread(1), _cursor(0), _ewma_level(75), _debug(false) {
 }
 
 Minstrel::~Minstrel() {
 }
 
-void Minstrel::run_timer(Timer *)
+void Minstrel::update_rates(DstInfo *nfo)
 {
-	for (NeighborIter iter = _neighbors.begin(); iter.live(); iter++) {
-		DstInfo *nfo = &iter.value();
-		int max_tp = 0, index_max_tp = 0, index_max_tp2 = 0;
-		int max_prob = 0, index_max_prob = 0;
-		uint32_t usecs;
-		int i;
-		uint32_t p;
-		for (i = 0; i < nfo->rates.size(); i++) {
-			if (nfo->flags & WIFI_EXTRA_MCS) {
-				usecs = calc_usecs_wifi_packet_ht(1500, nfo->rates[i], 0);
-			} else {
-				usecs = calc_usecs_wifi_packet(1500, nfo->rates[i], 0);
-			}
-			if (!usecs) {
-				usecs = 1000000;
-			}
-			/* To avoid rounding issues, probabilities scale from 0 (0%)
-			 * to 18000 (100%) */
-			if (nfo->attempts[i]) {
-				p = (nfo->successes[i] * 18000) / nfo->attempts[i];
-				nfo->hist_successes[i] += nfo->successes[i];
-				nfo->hist_attempts[i] += nfo->attempts[i];
-				nfo->cur_prob[i] = p;
-				p = ((p * (100 - _ewma_level)) + (nfo->probability[i] * _ewma_level)) / 100;
-				nfo->probability[i] = p;
-				nfo->cur_tp[i] = p * (1000000 / usecs);
-			}
-			nfo->last_successes[i] = nfo->successes[i];
-			nfo->last_attempts[i] = nfo->attempts[i];
-			nfo->successes[i] = 0;
-			nfo->attempts[i] = 0;
-			/* Sample less often below the 10% chance of success.
-			 * Sample less often above the 95% chance of success. */
-			if ((nfo->probability[i] > 17100) || (nfo->probability[i] < 1800)) {
-				nfo->sample_limit[i] = 4;
-			} else {
-				nfo->sample_limit[i] = -1;
-			}
+	int max_tp = 0, max_tp2 = 0, index_max_tp = 0, index_max_tp2 = 0;
+	int max_prob = 0, index_max_prob = 0;
+	int n = nfo->rates.size();
+	int *successes = nfo->successes.begin();
+	int *attempts = nfo->attempts.begin();
+	int *probability = nfo->probability.begin();
+	int *cur_tp = nfo->cur_tp.begin();
+	uint32_t p;
+	for (int i = 0; i < n; i++) {
+		/* To avoid rounding issues, probabilities scale from 0 (0%)
+		 * to 18000 (100%) */
+		if (attempts[i]) {
+			p = (successes[i] * 18000) / attempts[i];
+			nfo->hist_successes[i] += successes[i];
+			nfo->hist_attempts[i] += attempts[i];
+			nfo->cur_prob[i] = p;
+			p = ((p * (100 - _ewma_level)) + (probability[i] * _ewma_level)) / 100;
+			probability[i] = p;
+			cur_tp[i] = p * nfo->tp_scale[i];
 		}
-		for (i = 0; i < nfo->rates.size(); i++) {
-			if (max_tp < nfo->cur_tp[i]) {
-				index_max_tp = i;
-				max_tp = nfo->cur_tp[i];
-			}
-			if (max_prob < nfo->probability[i]) {
-				index_max_prob = i;
-				max_prob = nfo->probability[i];
-			}
+		nfo->last_successes[i] = successes[i];
+		nfo->last_attempts[i] = attempts[i];
+		successes[i] = 0;
+		attempts[i] = 0;
+		/* Sample less often below the 10% chance of success.
+		 * Sample less often above the 95% chance of success. */
+		if ((probability[i] > 17100) || (probability[i] < 1800)) {
+			nfo->sample_limit[i] = 4;
+		} else {
+			nfo->sample_limit[i] = -1;
 		}
-		max_tp = 0;
-		for (i = 0; i < nfo->rates.size(); i++) {
-			if (i == index_max_tp) {
-				continue;
-			}
-			if (max_tp < nfo->cur_tp[i]) {
-				index_max_tp2 = i;
-				max_tp = nfo->cur_tp[i];
-			}
+		/* Ties go to the lowest index, as the best rate is skipped
+		 * when looking for the second best one */
+		if (max_tp < cur_tp[i]) {
+			index_max_tp2 = index_max_tp;
+			max_tp2 = max_tp;
+			index_max_tp = i;
+			max_tp = cur_tp[i];
+		} else if (max_tp2 < cur_tp[i]) {
+			index_max_tp2 = i;
+			max_tp2 = cur_tp[i];
+		}
+		if (max_prob < probability[i]) {
+			index_max_prob = i;
+			max_prob = probability[i];
 		}
-		nfo->max_tp_rate = index_max_tp;
-		nfo->max_tp_rate2 = index_max_tp2;
-		nfo->max_prob_rate = index_max_prob;
 	}
-	_timer.schedule_after_msec(_period);
+	nfo->max_tp_rate = index_max_tp;
+	nfo->max_tp_rate2 = index_max_tp2;
+	nfo->max_prob_rate = index_max_prob;
+}
+
+void Minstrel::run_timer(Timer *)
+{
+	/* with SPREAD each tick covers the next slice of the neighbors */
+	int n = _dsts.size();
+	int slice = (n + _spread - 1) / _spread;
+	for (int i = 0; i < slice && _cursor < n; i++, _cursor++) {
+		update_rates(_dsts[_cursor]);
+	}
+	if (_cursor >= n) {
+		_cursor = 0;
+	}
+	_timer.schedule_after_msec(_period / _spread);
 }
 
 int Minstrel::initialize(ErrorHandler *)
@@ -121,10 +121,14 @@ int Minstrel::configure(Vector<String> &conf, ErrorHandler *errh)
 		      .read("LOOKAROUND_RATE", _lookaround_rate)
 		      .read("EWMA_LEVEL", _ewma_level)
 		      .read("PERIOD", _period)
+		      .read("SPREAD", _spread)
 		      .read("ACTIVE",  _active)
 		      .read("DEBUG",  _debug)
 		      .complete();
 
+	if (ret >= 0 && (_spread == 0 || _spread > _period))
+		return errh->error("SPREAD must be between 1 and PERIOD");
+
 	return ret;
 
 }
@@ -202,13 +206,18 @@ void Minstrel::assign_rate(Packet *p_in)
 			ceh->max_tries = WIFI_MAX_RETRIES + 1;
 			return;
 		}
+		bool fresh = !nfo;
 		if (rates_ht.size() > 0) {
-			_neighbors.insert(dst, DstInfo(dst, rates_ht));
-			nfo = _neighbors.findp(dst);
-			nfo->flags |= WIFI_EXTRA_MCS;
+			_neighbors.insert(dst, DstInfo(dst, rates_ht, true));
 		} else {
-			_neighbors.insert(dst, DstInfo(dst, rates));
-			nfo = _neighbors.findp(dst);
+			_neighbors.insert(dst, DstInfo(dst, rates, false));
+		}
+		nfo = _neighbors.findp(dst);
+		if (rates_ht.size() > 0) {
+			nfo->flags |= WIFI_EXTRA_MCS;
+		}
+		if (fresh) {
+			_dsts.push_back(nfo);
 		}
 	}
 
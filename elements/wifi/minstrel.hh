@@ -13,6 +13,10 @@ CLICK_DECLS
  * Minstrel([, I<KEYWORDS>])
  * =s Wifi
  * Minstrel wireless bit-rate selection algorithm
+ * =d
+ * Statistics are updated every PERIOD milliseconds. With SPREAD set to N the
+ * timer fires N times per period and each time only updates one Nth of the
+ * neighbors, so each neighbor is still updated once per period. Default is 1.
  * =a SetTXRate, FilterTX
  */
 
@@ -57,6 +61,7 @@ private:
 		Vector<int> cur_tp;
 		Vector<int> probability;
 		Vector<int> sample_limit;
+		Vector<int> tp_scale; /* packets per second for a 1500 byte frame */
 		uint8_t flags;
 		int packet_count;
 		int sample_count;
@@ -64,7 +69,7 @@ private:
 		int max_tp_rate2;
 		int max_prob_rate;
 		DstInfo() {}
-		DstInfo(EtherAddress neighbor, Vector<int> supported) {
+		DstInfo(EtherAddress neighbor, Vector<int> supported, bool ht) {
 			eth = neighbor;
 			int i;
 			for (i = 0; i < supported.size(); i++) {
@@ -81,6 +86,15 @@ private:
 			cur_tp = Vector<int>(supported.size(), 0);
 			probability = Vector<int>(supported.size(), 0);
 			sample_limit = Vector<int>(supported.size(), -1);
+			for (i = 0; i < supported.size(); i++) {
+				uint32_t usecs;
+				if (ht) {
+					usecs = calc_usecs_wifi_packet_ht(1500, supported[i], 0);
+				} else {
+					usecs = calc_usecs_wifi_packet(1500, supported[i], 0);
+				}
+				tp_scale.push_back(1000000 / (usecs ? usecs : 1000000));
+			}
 			packet_count = 0;
 			sample_count = 0;
 			max_tp_rate = 0;
@@ -106,10 +120,13 @@ private:
 		}
 	};
 
+	void update_rates(DstInfo *);
+
 	typedef HashMap<EtherAddress, DstInfo> NeighborTable;
 	typedef NeighborTable::iterator NeighborIter;
 
 	NeighborTable _neighbors;
+	Vector<DstInfo *> _dsts; /* neighbors in insertion order */
 	AvailableRates *_rtable;
 	AvailableRates *_rtable_ht;
 	Timer _timer;
@@ -118,6 +135,8 @@ private:
 	unsigned _offset;
 	bool _active;
 	unsigned _period;
+	unsigned _spread;
+	int _cursor;
 	unsigned _ewma_level;
 	bool _debug;
 
@@ -20,16 +20,279 @@
 
 #include <click/config.h>
 #include "arptablemulti.hh"
+#include <click/master.hh>
 CLICK_DECLS
 
+int
+NodeEtherTable::intern(NodeAddress node)
+{
+    assert(node);
+    if ((_size + 1) * 2 > _entries.size()) {
+	Vector<Entry> old;
+	old.swap(_entries);
+	_entries.resize(old.size() ? old.size() * 2 : 64);
+	_mask = _entries.size() - 1;
+	_size = 0;
+	for (int i = 0; i < old.size(); i++)
+	    if (old[i]._node)
+		_entries[intern(old[i]._node)] = old[i];
+    }
+    uint32_t i = slot(node) & _mask;
+    while (_entries[i]._node && !(_entries[i]._node == node))
+	i = (i + 1) & _mask;
+    if (!_entries[i]._node) {
+	_entries[i]._node = node;
+	_size++;
+    }
+    return i;
+}
+
+void
+NodeEtherTable::forget()
+{
+    for (int i = 0; i < _entries.size(); i++)
+	_entries[i]._eth = EtherAddress::make_broadcast();
+}
+
+void
+NodeEtherTable::clear()
+{
+    _entries.clear();
+    _size = 0;
+    _mask = 0;
+}
+
 ARPTableMulti::ARPTableMulti()
+    : _threadsafe(false), _dense(false), _writer(click_invalid_processor()), _lock_depth(0),
+      _views(0), _nviews(0)
 {
+    _version = 1;
 }
 
 ARPTableMulti::~ARPTableMulti()
 {
 }
 
+int
+ARPTableMulti::configure(Vector<String> &conf, ErrorHandler *errh)
+{
+    if (Args(this, errh).bind(conf)
+	.read("THREADSAFE", _threadsafe)
+	.read("DENSE", _dense)
+	.consume() < 0)
+	return -1;
+#if !CLICK_USERLEVEL || (HAVE_MULTITHREAD && !HAVE___THREAD_STORAGE_CLASS)
+    if (_threadsafe)
+	return errh->error("THREADSAFE is not supported in this driver");
+#endif
+    return ARPTableBase<NodeAddress>::configure(conf, errh);
+}
+
+int
+ARPTableMulti::initialize(ErrorHandler *errh)
+{
+    if (_threadsafe) {
+#if HAVE_MULTITHREAD
+	_nviews = master()->nthreads();
+#else
+	_nviews = 1;
+#endif
+    } else if (_dense)
+	_nviews = 1;
+    if (_nviews && !(_views = new ReaderView[_nviews]))
+	return errh->error("out of memory");
+    return 0;
+}
+
+void
+ARPTableMulti::cleanup(CleanupStage stage)
+{
+    ARPTableBase<NodeAddress>::cleanup(stage);
+    delete[] _views;
+    _views = 0;
+    _nviews = 0;
+}
+
+inline void
+ARPTableMulti::lock()
+{
+    if (_threadsafe) {
+	_write_lock.acquire();
+	if (_lock_depth++ == 0)
+	    _writer = click_current_processor();
+    }
+}
+
+inline void
+ARPTableMulti::unlock()
+{
+    if (_threadsafe) {
+	if (--_lock_depth == 0)
+	    _writer = click_invalid_processor();
+	_write_lock.release();
+    }
+}
+
+ARPTableMulti::ReaderView *
+ARPTableMulti::reader_view()
+{
+    if (!_views || _writer == click_current_processor())
+	return 0;
+#if HAVE_MULTITHREAD && HAVE___THREAD_STORAGE_CLASS
+    int x = click_current_thread_id;
+    return &_views[(unsigned) x < (unsigned) _nviews ? x : 0];
+#else
+    return &_views[0];
+#endif
+}
+
+void
+ARPTableMulti::refresh_view(ReaderView *v)
+{
+    _write_lock.acquire();
+    click_jiffies_t now = click_jiffies();
+    // addresses stay interned after they expire; start over once most
+    // of the array is made of them
+    if (v->_table.size() > 2 * (int) _entry_count + 64)
+	v->_table.clear();
+    else
+	v->_table.forget();
+    for (TIter it = _table.begin(); it; ++it)
+	if (it->known(now, _timeout_j))
+	    v->_table.set(it->_ip, it->_eth, it->_live_at_j);
+    v->_version = _version;
+    v->_refreshes++;
+    _write_lock.release();
+}
+
+EtherAddress
+ARPTableMulti::lookup(NodeAddress node)
+{
+    if (ReaderView *v = reader_view()) {
+	if (v->_version != _version)
+	    refresh_view(v);
+	// age mappings as ARPTableBase::lookup() does; a refresh of the
+	// same mapping does not change the version, so look again at the
+	// live table before giving up on one
+	click_jiffies_t now = click_jiffies();
+	const NodeEtherTable::Entry *e = v->_table.find(node);
+	if (e && !e->_eth.is_broadcast() && !e->known(now, _timeout_j)) {
+	    refresh_view(v);
+	    e = v->_table.find(node);
+	}
+	if (e && e->known(now, _timeout_j))
+	    return e->_eth;
+	return EtherAddress::make_broadcast();
+    }
+    return ARPTableBase<NodeAddress>::lookup(node);
+}
+
+int
+ARPTableMulti::insert(NodeAddress node, const EtherAddress &eth)
+{
+    // refreshing a known mapping leaves the readers' copies, and the
+    // headers cached from them, valid
+    lock();
+    EtherAddress old;
+    bool known = ARPTableBase<NodeAddress>::lookup(node, &old, 0) >= 0;
+    int r = ARPTableBase<NodeAddress>::insert(node, eth);
+    if (!known || old != eth)
+	_version++;
+    unlock();
+    return r;
+}
+
+void
+ARPTableMulti::run_timer(Timer *timer)
+{
+    lock();
+    uint32_t count = _entry_count;
+    ARPTableBase<NodeAddress>::run_timer(timer);
+    if (count != _entry_count)
+	_version++;
+    unlock();
+}
+
+enum { h_views = ARPTableBase<NodeAddress>::h_clear + 1, h_interned };
+
+String
+ARPTableMulti::read_handler(Element *e, void *user_data)
+{
+    ARPTableMulti *arpt = (ARPTableMulti *) e;
+    StringAccum sa;
+    arpt->lock();
+    switch (reinterpret_cast<uintptr_t>(user_data)) {
+    case h_views:
+	for (int x = 0; x < arpt->_nviews; x++) {
+	    ReaderView &v = arpt->_views[x];
+	    sa << "thread " << x << " version " << v._version
+	       << " refreshes " << v._refreshes
+	       << " interned " << v._table.size()
+	       << " capacity " << v._table.capacity() << '\n';
+	}
+	break;
+    case h_interned: {
+	int interned = 0;
+	for (int x = 0; x < arpt->_nviews; x++)
+	    if (arpt->_views[x]._table.size() > interned)
+		interned = arpt->_views[x]._table.size();
+	sa << interned << '\n';
+	break;
+    }
+    default:
+	sa << ARPTableBase<NodeAddress>::read_handler(e, user_data);
+	break;
+    }
+    arpt->unlock();
+    return sa.take_string();
+}
+
+int
+ARPTableMulti::write_handler(const String &str, Element *e, void *user_data, ErrorHandler *errh)
+{
+    ARPTableMulti *arpt = (ARPTableMulti *) e;
+    int r = 0;
+    arpt->lock();
+    switch (reinterpret_cast<uintptr_t>(user_data)) {
+    case h_insert:
+    case h_delete: {
+	Vector<String> words;
+	cp_spacevec(str, words);
+	NodeAddress node;
+	EtherAddress eth = EtherAddress::make_broadcast();
+	bool insert = reinterpret_cast<uintptr_t>(user_data) == h_insert;
+	if (words.size() != (insert ? 2 : 1) || !cp_node_address(words[0], &node))
+	    r = errh->error(insert ? "expected NODE ETH" : "expected NODE");
+	else if (insert && !EtherAddressArg().parse(words[1], eth))
+	    r = errh->error("bad Ethernet address");
+	else
+	    // delete marks the mapping unknown, as in ARPTable
+	    arpt->ARPTableBase<NodeAddress>::insert(node, eth);
+	break;
+    }
+    default:
+	r = ARPTableBase<NodeAddress>::write_handler(str, e, user_data, errh);
+	break;
+    }
+    arpt->_version++;
+    arpt->unlock();
+    return r;
+}
+
+void
+ARPTableMulti::add_handlers()
+{
+    ARPTableBase<NodeAddress>::add_handlers();
+    // rebind the table handlers so they run under the writer lock
+    add_read_handler("table", read_handler, h_table);
+    add_read_handler("views", read_handler, h_views);
+    add_read_handler("interned", read_handler, h_interned);
+    add_write_handler("insert", write_handler, h_insert);
+    add_write_handler("delete", write_handler, h_delete);
+    add_write_handler("clear", write_handler, h_clear);
+}
+
 CLICK_ENDDECLS
 EXPORT_ELEMENT(ARPTableMulti)
+ELEMENT_REQUIRES(NodeAddress)
 ELEMENT_MT_SAFE(ARPTableMulti)
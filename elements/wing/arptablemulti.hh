@@ -4,6 +4,124 @@
 #include "wingpacket.hh"
 CLICK_DECLS
 
+/*
+=c
+
+ARPTableMulti(I<keywords>)
+
+=s Wifi
+
+stores NodeAddress-to-Ethernet mappings
+
+=d
+
+ARPTable for NodeAddress keys, used by the WING elements. Keyword
+arguments are as for ARPTable, plus:
+
+=over 8
+
+=item THREADSAFE
+
+Boolean. If true, the table can be shared by elements running on different
+threads. Inserts, expiry and handlers are serialized by a lock, while
+lookups are served from a per-thread copy of the known mappings that is
+refreshed only when a mapping is added, changed or removed. Default is
+false.
+
+=item DENSE
+
+Boolean. If true, lookups are served from a flat array in which every
+NodeAddress is given a slot the first time it is inserted. Mesh addresses
+differ in their low bits, so a lookup is usually a single array access
+instead of a hash table probe. Each slot keeps the time its mapping was
+last confirmed, so mappings older than TIMEOUT are not served, as with
+ARPTable, even before the expiry timer removes them. THREADSAFE tables
+always use this layout for their per-thread copies. Default is false.
+
+=back
+
+=h insert w
+
+Takes a NodeAddress (IP:IFACE) and an Ethernet address and adds the mapping.
+
+=h delete w
+
+Takes a NodeAddress and marks its mapping as unknown.
+
+=h views r
+
+Returns the version of each thread's copy of the table, how many times it
+was refreshed, and how many addresses it has interned.
+
+=h interned r
+
+Returns the largest number of addresses interned by any copy of the table.
+
+=a
+
+ARPTable, LinkTableMulti
+*/
+
+/* open-addressed NodeAddress to EtherAddress array; addresses keep their
+ * slot until the array grows or is cleared */
+class NodeEtherTable { public:
+
+    struct Entry {
+	NodeAddress _node;
+	EtherAddress _eth;
+	click_jiffies_t _live_at_j;
+	Entry()
+	    : _eth(EtherAddress::make_broadcast()), _live_at_j(0) {
+	}
+	bool known(click_jiffies_t now, uint32_t timeout_j) const {
+	    return !_eth.is_broadcast()
+		&& (!timeout_j || !click_jiffies_less(_live_at_j + timeout_j, now));
+	}
+    };
+
+    NodeEtherTable()
+	: _size(0), _mask(0) {
+    }
+
+    int size() const			{ return _size; }
+    int capacity() const		{ return _entries.size(); }
+
+    inline const Entry *find(NodeAddress node) const;
+    int intern(NodeAddress node);
+    void set(NodeAddress node, const EtherAddress &eth, click_jiffies_t live_at_j) {
+	Entry &e = _entries[intern(node)];
+	e._eth = eth;
+	e._live_at_j = live_at_j;
+    }
+    void forget();
+    void clear();
+
+  private:
+
+    Vector<Entry> _entries;
+    int _size;
+    uint32_t _mask;
+
+    static inline uint32_t slot(NodeAddress node) {
+	return (ntohl(node._ip.addr()) << 3) ^ node._iface;
+    }
+
+};
+
+inline const NodeEtherTable::Entry *
+NodeEtherTable::find(NodeAddress node) const
+{
+    if (!_size || !node)
+	return 0;
+    for (uint32_t i = slot(node) & _mask; ; i = (i + 1) & _mask) {
+	const Entry &e = _entries[i];
+	if (e._node == node)
+	    return &e;
+	if (!e._node)
+	    return 0;
+    }
+}
+
 class ARPTableMulti : public ARPTableBase<NodeAddress> { public:
 
     ARPTableMulti();
@@ -11,6 +129,47 @@ class ARPTableMulti : public ARPTableBase<NodeAddress> { public:
 
     const char *class_name() const		{ return "ARPTableMulti"; }
 
+    int configure(Vector<String> &, ErrorHandler *) CLICK_COLD;
+    int initialize(ErrorHandler *) CLICK_COLD;
+    void cleanup(CleanupStage) CLICK_COLD;
+    void add_handlers() CLICK_COLD;
+    void run_timer(Timer *);
+
+    EtherAddress lookup(NodeAddress node);
+    int insert(NodeAddress node, const EtherAddress &eth);
+
+    // changes whenever a mapping is added, changed or removed
+    uint32_t version() const			{ return _version; }
+
+  private:
+
+    bool _threadsafe;
+    bool _dense;
+
+    // the writer lock is recursive, _writer names the thread holding it
+    Spinlock _write_lock;
+    click_processor_t _writer;
+    int _lock_depth;
+    atomic_uint32_t _version;
+
+    struct ReaderView {
+	uint32_t _version;
+	uint32_t _refreshes;
+	NodeEtherTable _table;
+	ReaderView() : _version(0), _refreshes(0) { }
+    };
+
+    ReaderView *_views;
+    int _nviews;
+
+    inline void lock();
+    inline void unlock();
+    ReaderView *reader_view();
+    void refresh_view(ReaderView *);
+
+    static String read_handler(Element *, void *) CLICK_COLD;
+    static int write_handler(const String &, Element *, void *, ErrorHandler *) CLICK_COLD;
+
 };
 
 CLICK_ENDDECLS
@@ -19,23 +19,15 @@
 #include <click/config.h>
 #include "linktablemulti.hh"
 #include <click/args.hh>
+#include <click/heap.hh>
+#include <click/master.hh>
 CLICK_DECLS
 
-bool
-cp_node_address(String s, NodeAddress *node)
-{
-	int sep = s.find_left(':');
-	IPAddress ip;
-	int iface;
-	if (!cp_ip_address(s.substring(0, sep), &ip) ||
-		!cp_integer(s.substring(sep + 1, s.length()), &iface)) {
-		return false;
-	}
-	*node = NodeAddress(ip, iface);
-	return true;
-}
-
-LinkTableMulti::LinkTableMulti() : _beta(20)
+LinkTableMulti::LinkTableMulti()
+  : _beta(20), _debug(false), _threadsafe(false),
+    _writer(click_invalid_processor()), _lock_depth(0),
+    _views(0), _nviews(0), _reachable_from_me(0),
+    _reachable_signature(0)
 {
 }
 
@@ -64,10 +56,18 @@ LinkTableMulti::configure(Vector<String> &conf, ErrorHandler *errh) {
           .read_m("IFACES", ifaces)
           .read("BETA", _beta)
           .read("STALE", stale_period)
+          .read("THRESHOLD", _flap_threshold)
           .read("DEBUG", _debug)
+          .read("THREADSAFE", _threadsafe)
           .complete())
       return -1;
 
+#if !CLICK_USERLEVEL || (HAVE_MULTITHREAD && !HAVE___THREAD_STORAGE_CLASS)
+    if (_threadsafe) {
+        return errh->error("THREADSAFE is not supported in this driver");
+    }
+#endif
+
     _ip = NodeAddress(ip, 0);
     _hosts.insert(_ip, HostInfo(_ip));
 
@@ -92,10 +92,69 @@ LinkTableMulti::configure(Vector<String> &conf, ErrorHandler *errh) {
     return 0;
 }
 
+int
+LinkTableMulti::initialize(ErrorHandler *errh) {
+    if (_threadsafe) {
+#if HAVE_MULTITHREAD
+        _nviews = master()->nthreads();
+#else
+        _nviews = 1;
+#endif
+        if (!(_views = new ReaderView[_nviews])) {
+            return errh->error("out of memory");
+        }
+    }
+    return LinkTableBase<NodeAddress, PathMulti>::initialize(errh);
+}
+
+void
+LinkTableMulti::cleanup(CleanupStage) {
+    delete[] _views;
+    _views = 0;
+    _nviews = 0;
+}
+
+void
+LinkTableMulti::run_timer(Timer *t) {
+    lock();
+    LinkTableBase<NodeAddress, PathMulti>::run_timer(t);
+    unlock();
+}
+
+LinkTableMulti::ReaderView *
+LinkTableMulti::reader_view() {
+    if (!_views || _writer == click_current_processor()) {
+        return 0;
+    }
+#if HAVE_MULTITHREAD && HAVE___THREAD_STORAGE_CLASS
+    int x = click_current_thread_id;
+    ReaderView *v = &_views[(unsigned) x < (unsigned) _nviews ? x : 0];
+#else
+    ReaderView *v = &_views[0];
+#endif
+    if (v->_epoch != _route_epoch) {
+        refresh_view(v);
+    }
+    return v;
+}
+
+void
+LinkTableMulti::refresh_view(ReaderView *v) {
+    _lock.acquire();
+    v->_hosts = _hosts;
+    v->_links = _links;
+    v->_blacklist = _blacklist;
+    v->_ifaces = local_interfaces(_hosts);
+    v->_epoch = _route_epoch;
+    v->_refreshes++;
+    _lock.release();
+}
+
 bool 
 LinkTableMulti::update_link_table(Packet *p) {
 	click_ether *eh = (click_ether *) p->data();
 	struct wing_packet *pk = (struct wing_packet *) (eh + 1);
+	lock();
 	/* update the metrics from the packet */
 	for (int i = 0; i < pk->num_links(); i++) {
 		NodeAddress a = pk->get_link_dep(i);
@@ -115,6 +174,7 @@ LinkTableMulti::update_link_table(Packet *p) {
 					seq,
 					channel,
 					b.unparse().c_str());
+			unlock();
 			return false;
 		}
 		if (_debug) {
@@ -158,24 +218,57 @@ LinkTableMulti::update_link_table(Packet *p) {
 	}
 	dijkstra(true);
 	dijkstra(false);
+	unlock();
 	return true;
 }
 
 PathMulti 
 LinkTableMulti::best_route(NodeAddress dst, bool from_me)
+{
+    if (ReaderView *v = reader_view()) {
+        return build_route(v->_hosts, dst, from_me);
+    }
+    return build_route(_hosts, dst, from_me);
+}
+
+const PathMulti &
+LinkTableMulti::cached_route(NodeAddress dst, bool from_me)
+{
+    ReaderView *v = reader_view();
+    if (!v) {
+        return LinkTableBase<NodeAddress, PathMulti>::cached_route(dst, from_me);
+    }
+    RouteCache &cache = from_me ? v->_routes_from_me : v->_routes_to_me;
+    CachedRoute *cr = cache.findp(dst);
+    if (cr && cr->_epoch == v->_epoch) {
+        v->_hits++;
+        return cr->_route;
+    }
+    v->_misses++;
+    if (!cr) {
+        cache.insert(dst, CachedRoute());
+        cr = cache.findp(dst);
+    }
+    cr->_route = build_route(v->_hosts, dst, from_me);
+    cr->_epoch = v->_epoch;
+    return cr->_route;
+}
+
+PathMulti
+LinkTableMulti::build_route(const HTable &hosts, NodeAddress dst, bool from_me)
 {
     PathMulti reverse_route;
     if (!dst) {
         return reverse_route;
     }
-    HostInfo *nfo = _hosts.findp(dst);
+    const HostInfo *nfo = hosts.findp(dst);
     if (from_me) {
         Vector<NodeAddress> raw_path;
         while (nfo && nfo->_metric_from_me != 0) {
             if (nfo->_address._iface != 0) {
                 raw_path.push_back(nfo->_address);
             }
-            nfo = _hosts.findp(nfo->_prev_from_me);
+            nfo = hosts.findp(nfo->_prev_from_me);
         }
         if (raw_path.size() < 1) {
             return reverse_route;
@@ -196,7 +289,7 @@ LinkTableMulti::best_route(NodeAddress dst, bool from_me)
             if (nfo->_address._iface != 0) {
                 raw_path.push_back(nfo->_address);
             }
-            nfo = _hosts.findp(nfo->_prev_to_me);
+            nfo = hosts.findp(nfo->_prev_to_me);
         }
         if (raw_path.size() < 1) {
             return reverse_route;
@@ -277,6 +370,93 @@ LinkTableMulti::print_routes(bool from_me, bool pretty)
     return sa.take_string();
 }
 
+const LinkTableMulti::LinkInfo *
+LinkTableMulti::find_link(NodeAddress from, NodeAddress to) {
+    if (!from || !to) {
+        return 0;
+    }
+    ReaderView *v = reader_view();
+    const AddressTable &blacklist = v ? v->_blacklist : _blacklist;
+    if (blacklist.findp(from) || blacklist.findp(to)) {
+        return 0;
+    }
+    const LTable &links = v ? v->_links : _links;
+    return links.findp(AddressPair(from, to));
+}
+
+const LinkTableMulti::HostInfo *
+LinkTableMulti::find_host(NodeAddress s) {
+    if (!s) {
+        return 0;
+    }
+    ReaderView *v = reader_view();
+    const HTable &hosts = v ? v->_hosts : _hosts;
+    return hosts.findp(s);
+}
+
+uint32_t
+LinkTableMulti::get_host_metric_to_me(NodeAddress s) {
+    const HostInfo *nfo = find_host(s);
+    return nfo ? nfo->_metric_to_me : 0;
+}
+
+uint32_t
+LinkTableMulti::get_host_metric_from_me(NodeAddress s) {
+    const HostInfo *nfo = find_host(s);
+    return nfo ? nfo->_metric_from_me : 0;
+}
+
+uint16_t
+LinkTableMulti::get_link_channel(NodeAddress from, NodeAddress to) {
+    const LinkInfo *nfo = find_link(from, to);
+    return nfo ? nfo->_channel : 0;
+}
+
+uint32_t
+LinkTableMulti::get_link_metric(NodeAddress from, NodeAddress to) {
+    const LinkInfo *nfo = find_link(from, to);
+    return nfo ? nfo->_metric : 0;
+}
+
+uint32_t
+LinkTableMulti::get_link_seq(NodeAddress from, NodeAddress to) {
+    const LinkInfo *nfo = find_link(from, to);
+    return nfo ? nfo->_seq : 0;
+}
+
+uint32_t
+LinkTableMulti::get_link_age(NodeAddress from, NodeAddress to) {
+    const LinkInfo *nfo = find_link(from, to);
+    if (!nfo) {
+        return 0;
+    }
+    LinkInfo l = *nfo;
+    return l.age();
+}
+
+Vector<int>
+LinkTableMulti::local_interfaces(const HTable &hosts) {
+    Vector<int> ifaces;
+    for (HTIter iter = hosts.begin(); iter.live(); iter++) {
+        if ((iter.key()._ip == _ip._ip) && (iter.key()._iface != 0)) {
+            ifaces.push_back(iter.key()._iface);
+        }
+    }
+    return ifaces;
+}
+
+Vector<int>
+LinkTableMulti::get_local_interfaces() {
+    ReaderView *v = reader_view();
+    if (v && v->_epoch) {
+        return v->_ifaces;
+    }
+    lock();
+    Vector<int> ifaces = local_interfaces(_hosts);
+    unlock();
+    return ifaces;
+}
+
 uint32_t 
 LinkTableMulti::get_route_metric(const PathMulti &route) {
     unsigned metric = 0;
@@ -292,174 +472,169 @@ LinkTableMulti::get_route_metric(const PathMulti &route) {
     return metric;
 }
 
-uint32_t
-LinkTableMulti::compute_metric(Vector<uint32_t> metrics, Vector<uint32_t> channels) {
-    if (metrics.size() != channels.size()) {
-          return 99999;
-    }
-    HashMap<uint32_t, uint32_t> mt;
-    uint32_t max = 0;
-    uint32_t ett = 0;
-    for (int x = 0; x < metrics.size(); x++) {
-        uint32_t *nc = mt.findp(channels[x]);
-       if (!nc) {
-           mt.insert(channels[x], 0);
-           nc = mt.findp(channels[x]);
-       }
-       *nc += metrics[x];
-       ett += metrics[x];
-    }
-    for (HashMap<uint32_t, uint32_t>::const_iterator iter = mt.begin(); iter.live(); iter++) {
-        if (iter.value() > max) {
-           max=iter.value();
-        }
-    }
-    return (ett * (100 - _beta) + max * _beta) / 100;
-}
-
 void
 LinkTableMulti::dijkstra(bool from_me)
 {
 
+  lock();
+  if (!dijkstra_needed(from_me)) {
+    unlock();
+    return;
+  }
+
   Timestamp start = Timestamp::now();
 
+  /* index every host and clear its state */
+  _dj_nodes.resize(_host_addrs.size());
+  for (HashMap<NodeAddress, HostInfo>::iterator iter = _hosts.begin(); iter.live(); iter++) {
+    HostInfo *n = &iter.value();
+    n->clear(from_me);
+    int x = host_index(n->_address);
+    if (x >= _dj_nodes.size()) {
+      _dj_nodes.resize(x + 1);
+    }
+    DijkstraNode &dn = _dj_nodes[x];
+    dn._info = n;
+    dn._prev = -1;
+    dn._marked = false;
+    dn._metric = 0;
+  }
+
+  /* equal-metric ties are broken by the scan order of a freshly built
+   * address map, so that the same links always yield the same routes */
   typedef HashMap<NodeAddress, bool> AddressMap;
   typedef AddressMap::const_iterator AMIter;
 
   AddressMap addrs;
-
   for (HTIter iter = _hosts.begin(); iter.live(); iter++) {
     addrs.insert(iter.value()._address, true);
   }
-
+  int rank = 0;
   for (AMIter i = addrs.begin(); i.live(); i++) {
-    /* clear them all initially */
-    HostInfo *n = _hosts.findp(i.key());
-    n->clear(from_me);
+    _dj_nodes[host_index(i.key())]._rank = rank++;
   }
 
-  HostInfo *root_info = _hosts.findp(_ip);
-  assert(root_info);
-
-  if (from_me) {
-    root_info->_prev_from_me = root_info->_address;
-    root_info->_metric_from_me = 0;
-  } else {
-    root_info->_prev_to_me = root_info->_address;
-    root_info->_metric_to_me = 0;
+  if (_dj_channels.size() < _dj_nodes.size()) {
+    _dj_channels.resize(_dj_nodes.size());
   }
 
-  NodeAddress current_min_address = root_info->_address;
-
-  while (current_min_address) {
+  int root = host_index(_ip);
+  DijkstraNode &rn = _dj_nodes[root];
+  assert(rn._info);
+  rn._prev = root;
+  rn._ett = 0;
+  rn._max = 0;
+  _dj_channels[root].clear();
 
-    HostInfo *current_min = _hosts.findp(current_min_address);
-    assert(current_min);
-
-    if (from_me) {
-      current_min->_marked_from_me = true;
-    } else {
-      current_min->_marked_to_me = true;
-    }
+  _dj_heap.clear();
+  _dj_heap.push_back(HeapEntry(0, rn._rank, root));
 
-    for (AMIter i = addrs.begin(); i.live(); i++) {
+  while (_dj_heap.size()) {
 
-      HostInfo *neighbor = _hosts.findp(i.key());
-      assert(neighbor);
+    HeapEntry top = _dj_heap[0];
+    pop_heap(_dj_heap.begin(), _dj_heap.end(), heap_less());
+    _dj_heap.pop_back();
 
-      bool marked = neighbor->_marked_to_me;
-      if (from_me) {
-        marked = neighbor->_marked_from_me;
+    DijkstraNode &u = _dj_nodes[top._node];
+    if (u._marked || top._metric != u._metric) {
+      continue;
+    }
+    u._marked = true;
+
+    /* the path to u is now final: derive its per-channel costs from its
+     * predecessor's instead of walking the whole chain back to the root */
+    if (top._node != root) {
+      Vector<ChannelCost> &chans = _dj_channels[top._node];
+      chans = _dj_channels[u._prev];
+      int x = 0;
+      while (x < chans.size() && chans[x].first != u._via_channel) {
+        x++;
       }
-
-      if (marked) {
-        continue;
+      if (x == chans.size()) {
+        chans.push_back(ChannelCost(u._via_channel, 0));
       }
+      chans[x].second += u._via_metric;
+    }
+    const Vector<ChannelCost> &chans = _dj_channels[top._node];
 
-      AddressPair pair = AddressPair(neighbor->_address, current_min_address);
-      if (from_me) {
-        pair = AddressPair(current_min_address, neighbor->_address);
-      }
-      LinkInfo *lnfo = _links.findp(pair);
+    const EdgeList &edges = from_me ? _out_edges[top._node] : _in_edges[top._node];
+    for (int e = 0; e < edges.size(); e++) {
 
-      if (!lnfo || !lnfo->_metric || !lnfo->_channel) {
-        continue;
-      }
+      const LinkEdge &edge = edges[e];
+      DijkstraNode &v = _dj_nodes[edge._peer];
 
-      Vector<uint32_t> metrics;
-      Vector<uint32_t> channels;
-
-      HostInfo * thi = current_min;
-
-      if (from_me) {
-          while (thi->_prev_from_me != thi->_address) {
-              AddressPair prev = AddressPair(thi->_prev_from_me, thi->_address);
-              LinkInfo *tli = _links.findp(prev);
-              if (tli) {
-                  metrics.push_back(tli->_metric);
-                  channels.push_back(tli->_channel);
-              }
-              thi = _hosts.findp(thi->_prev_from_me);
-          }
-      } else {
-          while (thi->_prev_to_me != thi->_address) {
-              AddressPair prev = AddressPair(thi->_address, thi->_prev_to_me);
-              LinkInfo *tli = _links.findp(prev);
-              if (tli) {
-                  metrics.push_back(tli->_metric);
-                  channels.push_back(tli->_channel);
-              }
-              thi = _hosts.findp(thi->_prev_to_me);
-          }
+      if (v._marked || !edge._metric || !edge._channel) {
+        continue;
       }
 
-      metrics.push_back(lnfo->_metric);
-      channels.push_back(lnfo->_channel);
-
-      uint32_t neighbor_metric = neighbor->_metric_to_me;
-      if (from_me) {
-        neighbor_metric = neighbor->_metric_from_me;
+      uint32_t channel_cost = edge._metric;
+      for (int x = 0; x < chans.size(); x++) {
+        if (chans[x].first == edge._channel) {
+          channel_cost += chans[x].second;
+          break;
+        }
       }
 
-      uint32_t adjusted_metric = compute_metric(metrics, channels);
-
-      if (!neighbor_metric || adjusted_metric < neighbor_metric) {
-        if (from_me) {
-          neighbor->_metric_from_me = adjusted_metric;
-          neighbor->_prev_from_me = current_min_address;
-        } else {
-          neighbor->_metric_to_me = adjusted_metric;
-          neighbor->_prev_to_me = current_min_address;
-        }
+      uint32_t ett = u._ett + edge._metric;
+      uint32_t max = (channel_cost > u._max) ? channel_cost : u._max;
+      uint32_t adjusted_metric = compute_metric(ett, max);
+
+      if (!v._metric || adjusted_metric < v._metric) {
+        v._metric = adjusted_metric;
+        v._ett = ett;
+        v._max = max;
+        v._prev = top._node;
+        v._via_metric = edge._metric;
+        v._via_channel = edge._channel;
+        _dj_heap.push_back(HeapEntry(adjusted_metric, v._rank, edge._peer));
+        push_heap(_dj_heap.begin(), _dj_heap.end(), heap_less());
       }
     }
+  }
 
-    current_min_address = NodeAddress();
-    uint32_t  min_metric = ~0;
-    for (AMIter i = addrs.begin(); i.live(); i++) {
-      HostInfo *nfo = _hosts.findp(i.key());
-      uint32_t metric = nfo->_metric_to_me;
-      bool marked = nfo->_marked_to_me;
-      if (from_me) {
-        metric = nfo->_metric_from_me;
-        marked = nfo->_marked_from_me;
-      }
-      if (!marked && metric && metric < min_metric) {
-        current_min_address = nfo->_address;
-        min_metric = metric;
-      }
+  uint32_t reachable = 0, signature = 0;
+  for (int x = 0; x < _dj_nodes.size(); x++) {
+    DijkstraNode &dn = _dj_nodes[x];
+    if (!dn._marked) {
+      continue;
+    }
+    reachable++;
+    // order-independent digest of the reachable set
+    signature += CLICK_NAME(hashcode)(_host_addrs[x]) * 2654435761U;
+    if (from_me) {
+      dn._info->_metric_from_me = dn._metric;
+      dn._info->_prev_from_me = _host_addrs[dn._prev];
+      dn._info->_marked_from_me = true;
+    } else {
+      dn._info->_metric_to_me = dn._metric;
+      dn._info->_prev_to_me = _host_addrs[dn._prev];
+      dn._info->_marked_to_me = true;
     }
   }
 
+  if (from_me) {
+    _reachable_from_me = reachable;
+    _reachable_signature = signature;
+  }
   _dijkstra_time = Timestamp::now() - start;
 
+  for (int x = 0; x < _route_listeners.size(); x++) {
+    if (!_route_listeners[x]->scheduled()) {
+      _route_listeners[x]->schedule_now();
+    }
+  }
+
+  unlock();
+
 }
 
-enum { H_HOST_INTERFACES };
+enum { H_HOST_INTERFACES = H_ROUTE_CACHE + 1, H_VIEWS };
 
 String 
 LinkTableMulti::read_handler(Element *e, void *thunk) {
   LinkTableMulti *td = (LinkTableMulti *) e;
+  String s;
+  td->lock();
   switch ((uintptr_t) thunk) {
     case H_HOST_INTERFACES: {
       Vector<int> ifaces = td->get_local_interfaces();
@@ -467,17 +642,34 @@ LinkTableMulti::read_handler(Element *e, void *thunk) {
       for (int x = 0; x < ifaces.size(); x++) {
         sa << ifaces[x] << "\n";
       }
-      return sa.take_string();
+      s = sa.take_string();
+      break;
+    }
+    case H_VIEWS: {
+      StringAccum sa;
+      for (int x = 0; x < td->_nviews; x++) {
+        ReaderView &v = td->_views[x];
+        sa << "thread " << x;
+        sa << " epoch " << v._epoch;
+        sa << " refreshes " << v._refreshes;
+        sa << " hits " << v._hits;
+        sa << " misses " << v._misses << "\n";
+      }
+      s = sa.take_string();
+      break;
     }
     default:
-      return LinkTableBase<NodeAddress, PathMulti>::read_handler(e, thunk);
+      s = LinkTableBase<NodeAddress, PathMulti>::read_handler(e, thunk);
     }
+  td->unlock();
+  return s;
 }
 
 int 
 LinkTableMulti::write_handler(const String &in_s, Element *e, void *vparam, ErrorHandler * errh) {
   LinkTableMulti *f = (LinkTableMulti *) e;
-  String s = cp_uncomment(in_s);
+  int r = 0;
+  f->lock();
   switch ((intptr_t) vparam) {
     case H_UPDATE_LINK: {
       Vector<String> args;
@@ -489,40 +681,60 @@ LinkTableMulti::write_handler(const String &in_s, Element *e, void *vparam, Erro
       uint32_t channel;
       cp_spacevec(in_s, args);
       if (args.size() != 6) {
-        return errh->error("Must have six arguments: currently has %d: %s", args.size(), args[0].c_str());
-      }
-      if (!cp_node_address(args[0], &from)) {
-        return errh->error("Couldn't read NodeAddress out of from");
-      }
-      if (!cp_node_address(args[1], &to)) {
-        return errh->error("Couldn't read NodeAddress out of to");
-      }
-      if (!cp_unsigned(args[2], &metric)) {
-        return errh->error("Couldn't read metric");
-      }
-      if (!cp_unsigned(args[3], &seq)) {
-        return errh->error("Couldn't read seq");
-      }
-      if (!cp_unsigned(args[4], &age)) {
-        return errh->error("Couldn't read age");
-      }
-      if (!cp_unsigned(args[5], &channel)) {
-        return errh->error("Couldn't read channel");
+        r = errh->error("Must have six arguments: currently has %d: %s", args.size(), args[0].c_str());
+      } else if (!cp_node_address(args[0], &from)) {
+        r = errh->error("Couldn't read NodeAddress out of from");
+      } else if (!cp_node_address(args[1], &to)) {
+        r = errh->error("Couldn't read NodeAddress out of to");
+      } else if (!cp_unsigned(args[2], &metric)) {
+        r = errh->error("Couldn't read metric");
+      } else if (!cp_unsigned(args[3], &seq)) {
+        r = errh->error("Couldn't read seq");
+      } else if (!cp_unsigned(args[4], &age)) {
+        r = errh->error("Couldn't read age");
+      } else if (!cp_unsigned(args[5], &channel)) {
+        r = errh->error("Couldn't read channel");
+      } else {
+        f->update_link(from, to, seq, age, metric, channel);
       }
-      f->update_link(from, to, seq, age, metric, channel);
       break;
     }
     default: {
-      return LinkTableBase<NodeAddress, PathMulti>::write_handler(in_s, e, vparam, errh);
+      r = LinkTableBase<NodeAddress, PathMulti>::write_handler(in_s, e, vparam, errh);
+      break;
     }
   }
-  return 0;
+  /* blacklist changes do not recompute the routes, make the readers
+   * pick them up anyway */
+  f->_route_epoch++;
+  f->unlock();
+  return r;
 }
 
 void
 LinkTableMulti::add_handlers() {
-    LinkTableBase<NodeAddress, PathMulti>::add_handlers();
+    /* the base handlers are rebound here so that they run under the
+     * writer lock in THREADSAFE mode */
+    add_read_handler("ip", read_handler, H_HOST_IP);
+    add_read_handler("routes", read_handler, H_ROUTES_FROM);
+    add_read_handler("routes_old", read_handler, H_ROUTES_OLD);
+    add_read_handler("routes_from", read_handler, H_ROUTES_FROM);
+    add_read_handler("routes_to", read_handler, H_ROUTES_TO);
+    add_read_handler("links", read_handler, H_LINKS);
+    add_read_handler("hosts", read_handler, H_HOSTS);
+    add_read_handler("blacklist", read_handler, H_BLACKLIST);
+    add_read_handler("dijkstra_time", read_handler, H_DIJKSTRA_TIME);
+    add_read_handler("dijkstra_runs", read_handler, H_DIJKSTRA_RUNS);
+    add_read_handler("dijkstra_skipped", read_handler, H_DIJKSTRA_SKIPPED);
+    add_read_handler("damped_updates", read_handler, H_DAMPED_UPDATES);
+    add_read_handler("route_cache", read_handler, H_ROUTE_CACHE);
     add_read_handler("interfaces", read_handler, H_HOST_INTERFACES);
+    add_read_handler("views", read_handler, H_VIEWS);
+    add_write_handler("clear", write_handler, H_CLEAR);
+    add_write_handler("blacklist_clear", write_handler, H_BLACKLIST_CLEAR);
+    add_write_handler("blacklist_add", write_handler, H_BLACKLIST_ADD);
+    add_write_handler("blacklist_remove", write_handler, H_BLACKLIST_REMOVE);
+    add_write_handler("dijkstra", write_handler, H_DIJKSTRA);
     add_write_handler("update_link", write_handler, H_UPDATE_LINK);
 }
 
@@ -2,18 +2,40 @@
 #define CLICK_LINKTABLEMULTI_HH
 #include <elements/wifi/linktable.hh>
 #include <clicknet/ether.h>
+#include <click/pair.hh>
+#include <click/sync.hh>
 #include "wingpacket.hh"
 CLICK_DECLS
 
 /*
  * =c
- * LinkTableMulti(IP Address, [STALE timeout])
+ * LinkTableMulti(IP Address, IFACES interfaces, [STALE timeout, THRESHOLD percent, THREADSAFE bool])
  * =s Wifi
  * Keeps a Link state database and calculates Weighted Shortest Path
  * for other elements
  * =d
- * Runs dijkstra's algorithm occasionally.
- * =a ARPTable
+ * Runs dijkstra's algorithm occasionally. The shortest path tree is computed
+ * with a binary heap over the dense adjacency lists kept by LinkTableBase;
+ * the per-channel cost of each partial path is carried along the tree so
+ * that every relaxation costs O(1).
+ *
+ * Routes are only recomputed when a link change can affect them. Metric
+ * changes smaller than THRESHOLD percent of the metric in use are ignored
+ * (default 0, every change counts).
+ *
+ * With THREADSAFE true (default false) the table can be shared by elements
+ * running on different threads, for example one forwarding path per radio
+ * interface placed with StaticThreadSched. Updates and route computations
+ * are serialized by a lock. Route, link and host metric lookups on the
+ * other threads are served from a per-thread copy of the tables, taken at
+ * the first lookup after the routes change, so that they never wait on the
+ * writers. A reference returned by cached_route() stays valid until the
+ * same thread calls cached_route() again.
+ *
+ * Elements that react to route changes can register a Timer with
+ * add_route_listener(); it is scheduled to fire as soon as possible every
+ * time dijkstra recomputes the routes.
+ * =a ARPTable, ARPTableMulti
  *
  */
 
@@ -27,51 +49,160 @@ class LinkTableMulti : public LinkTableBase<NodeAddress, PathMulti> {
     const char *class_name() const { return "LinkTableMulti"; }
     void *cast(const char *);
     int configure (Vector<String> &, ErrorHandler *);
+    int initialize(ErrorHandler *);
+    void cleanup(CleanupStage);
     void add_handlers();
+    void run_timer(Timer *);
 
     PathMulti best_route(NodeAddress, bool);
+    const PathMulti &cached_route(NodeAddress, bool);
     String print_routes(bool, bool);
     String route_to_string(PathMulti);
     uint32_t get_route_metric(const PathMulti &);
     void dijkstra(bool);
 
+    uint16_t get_link_channel(NodeAddress, NodeAddress);
+    uint32_t get_link_metric(NodeAddress, NodeAddress);
+    uint32_t get_link_seq(NodeAddress, NodeAddress);
+    uint32_t get_link_age(NodeAddress, NodeAddress);
+
+    uint32_t get_host_metric_to_me(NodeAddress);
+    uint32_t get_host_metric_from_me(NodeAddress);
+
     inline bool update_link(NodeAddress node) {	
-      if (LinkTableBase<NodeAddress, PathMulti>::update_link(node, node._ip, Timestamp::now().sec(), 0, 1, 1)) {
-        return LinkTableBase<NodeAddress, PathMulti>::update_link(node._ip, node, Timestamp::now().sec(), 0, 1, 1);
-      }
-      return false;
+      lock();
+      bool ok = LinkTableBase<NodeAddress, PathMulti>::update_link(node, node._ip, Timestamp::now().sec(), 0, 1, 1) &&
+        LinkTableBase<NodeAddress, PathMulti>::update_link(node._ip, node, Timestamp::now().sec(), 0, 1, 1);
+      unlock();
+      return ok;
     }
 
     inline bool update_link(NodeAddress from, NodeAddress to, uint32_t seq, uint32_t age, uint32_t metric, uint16_t channel) {
-      if (update_link(from) &&
-          update_link(to) && 
-          LinkTableBase<NodeAddress, PathMulti>::update_link(from, to, seq, age, metric, channel)) {
-            return true;
-      }
-      return false;
+      lock();
+      bool ok = update_link(from) &&
+        update_link(to) &&
+        LinkTableBase<NodeAddress, PathMulti>::update_link(from, to, seq, age, metric, channel);
+      unlock();
+      return ok;
     }
 
     bool update_link_table(Packet *);
 
-    inline Vector<int> get_local_interfaces() {
-        Vector<int> ifaces;
-        for (HTIter iter = _hosts.begin(); iter.live(); iter++) {
-            if ((iter.key()._ip == _ip._ip) && (iter.key()._iface != 0)) {
-                ifaces.push_back(iter.key()._iface);
-            }
-        }
-        return ifaces;
+    Vector<int> get_local_interfaces();
+
+    /* hosts reached by the last dijkstra(true) run, and a digest of
+     * their addresses that changes whenever the set does */
+    uint32_t reachable_hosts() const { return _reachable_from_me; }
+    uint32_t reachable_signature() const { return _reachable_signature; }
+
+    void add_route_listener(Timer *t) {
+      lock();
+      _route_listeners.push_back(t);
+      unlock();
     }
 
   protected:
 
     uint32_t _beta;
     bool _debug;
+    bool _threadsafe;
+
+    /* THREADSAFE mode. The writer lock is recursive; _writer names the
+     * thread holding it so that the writer reads the live tables */
+    Spinlock _lock;
+    click_processor_t _writer;
+    int _lock_depth;
+
+    inline void lock() {
+      if (_threadsafe) {
+        _lock.acquire();
+        if (_lock_depth++ == 0) {
+          _writer = click_current_processor();
+        }
+      }
+    }
+
+    inline void unlock() {
+      if (_threadsafe) {
+        if (--_lock_depth == 0) {
+          _writer = click_invalid_processor();
+        }
+        _lock.release();
+      }
+    }
+
+    /* per-thread copy of the tables, refreshed by reader_view() when
+     * _route_epoch moves on */
+    class ReaderView {
+      public:
+        uint32_t _epoch;
+        HTable _hosts;
+        LTable _links;
+        AddressTable _blacklist;
+        Vector<int> _ifaces;
+        RouteCache _routes_from_me;
+        RouteCache _routes_to_me;
+        uint32_t _refreshes;
+        uint32_t _hits;
+        uint32_t _misses;
+        ReaderView() : _epoch(0), _refreshes(0), _hits(0), _misses(0) { }
+    };
+
+    ReaderView *_views;
+    int _nviews;
+
+    Vector<Timer *> _route_listeners;
+    uint32_t _reachable_from_me;
+    uint32_t _reachable_signature;
+
+    ReaderView *reader_view();
+    void refresh_view(ReaderView *);
+
+    PathMulti build_route(const HTable &, NodeAddress, bool);
+    Vector<int> local_interfaces(const HTable &);
+    const LinkInfo *find_link(NodeAddress, NodeAddress);
+    const HostInfo *find_host(NodeAddress);
 
     static String read_handler(Element *, void *);
     static int write_handler(const String &, Element *, void *, ErrorHandler *);
 
-    uint32_t compute_metric(Vector<uint32_t>, Vector<uint32_t>);
+    inline uint32_t compute_metric(uint32_t ett, uint32_t max) {
+        return (ett * (100 - _beta) + max * _beta) / 100;
+    }
+
+    /* per-run dijkstra state, indexed like LinkTableBase::_host_addrs */
+    typedef Pair<uint32_t, uint32_t> ChannelCost;
+
+    class DijkstraNode {
+      public:
+        HostInfo *_info;
+        int _rank;
+        int _prev;
+        bool _marked;
+        uint32_t _metric;
+        uint32_t _ett;
+        uint32_t _max;
+        uint32_t _via_metric;
+        uint32_t _via_channel;
+    };
+
+    class HeapEntry {
+      public:
+        uint32_t _metric;
+        int _rank;
+        int _node;
+        HeapEntry(uint32_t metric, int rank, int node) : _metric(metric), _rank(rank), _node(node) { }
+    };
+
+    struct heap_less {
+        inline bool operator()(const HeapEntry &a, const HeapEntry &b) {
+            return a._metric < b._metric || (a._metric == b._metric && a._rank < b._rank);
+        }
+    };
+
+    Vector<DijkstraNode> _dj_nodes;
+    Vector<Vector<ChannelCost> > _dj_channels;
+    Vector<HeapEntry> _dj_heap;
 
 };
 
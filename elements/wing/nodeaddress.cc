@@ -17,8 +17,26 @@
 
 #include <click/config.h>
 #include "nodeaddress.hh"
+#include <click/confparse.hh>
 CLICK_DECLS
 
+bool
+cp_node_address(String s, NodeAddress *node)
+{
+	int sep = s.find_left(':');
+	IPAddress ip;
+	int iface = 0;
+	if (sep < 0) {
+		sep = s.length();
+	}
+	if (!cp_ip_address(s.substring(0, sep), &ip) ||
+		(sep < s.length() && !cp_integer(s.substring(sep + 1, s.length()), &iface))) {
+		return false;
+	}
+	*node = NodeAddress(ip, iface);
+	return true;
+}
+
 StringAccum &
 operator<<(StringAccum &sa, NodeAddress na) {
 	const unsigned char *p = na._ip.data();
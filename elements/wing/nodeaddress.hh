@@ -62,5 +62,8 @@ class NodeAddress { public:
 
 StringAccum & operator<<(StringAccum &, NodeAddress);
 
+/** @brief Parse a NodeAddress of the form IP:IFACE (IFACE defaults to 0). */
+bool cp_node_address(String, NodeAddress *);
+
 CLICK_ENDDECLS
 #endif 
@@ -17,8 +17,8 @@ public:
 
 	void set_arr(NodeAddress p) { _ip = p._ip; _arr = p._iface; }
 	void set_dep(NodeAddress p) { _ip = p._ip; _dep = p._iface; }
-	NodeAddress arr() { return NodeAddress(_ip, _arr); }
-	NodeAddress dep() { return NodeAddress(_ip, _dep); }
+	NodeAddress arr() const { return NodeAddress(_ip, _arr); }
+	NodeAddress dep() const { return NodeAddress(_ip, _dep); }
 
 	typedef uint32_t (NodeAirport::*unspecified_bool_type)() const;
 	/** @brief Return true if the address is not 0.0.0.0. */
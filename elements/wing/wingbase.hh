@@ -3,6 +3,9 @@
 #include <click/element.hh>
 #include <click/deque.hh>
 #include <click/hashmap.hh>
+#include <click/heap.hh>
+#include <click/timer.hh>
+#include <click/straccum.hh>
 #include <click/packet_anno.hh>
 #include <clicknet/ether.h>
 #include <clicknet/wifi.h>
@@ -21,6 +24,8 @@ public:
 	const char *class_name() const { return "WINGBase"; }
 	const char *processing() const { return AGNOSTIC; }
 
+	int initialize(ErrorHandler *);
+
 	/* handler stuff */
 	void add_handlers();
 
@@ -35,7 +40,7 @@ protected:
 			_count(0),
 			_forwarded(false) {
 		}
-		Seen(T seen, int seq) : _seen(seen), _seq(seq), _count(0), _when(Timestamp::now()) {}
+		Seen(T seen, int seq) : _seen(seen), _seq(seq), _count(0), _when(Timestamp::now()), _forwarded(false) {}
 		T _seen;
 		int _seq;
 		int _count;
@@ -44,56 +49,126 @@ protected:
 		bool _forwarded;
 	};
 
+	class SeenKey {
+	public:
+		SeenKey() : _seen(T()), _seq(0) { }
+		SeenKey(T seen, int seq) : _seen(seen), _seq(seq) { }
+		T _seen;
+		int _seq;
+		inline hashcode_t hashcode() const {
+			return CLICK_NAME(hashcode)(_seen) + _seq;
+		}
+		inline bool operator==(const SeenKey &other) const {
+			return (other._seq == _seq && other._seen == _seen);
+		}
+	};
+
+	// Forwards waiting for their jittered send time, keyed by seen id.
+	class PendingForward {
+	public:
+		PendingForward(const Timestamp &to_send, uint32_t id) : _to_send(to_send), _id(id) { }
+		Timestamp _to_send;
+		uint32_t _id;
+	};
+
+	struct pending_less {
+		inline bool operator()(const PendingForward &a, const PendingForward &b) {
+			return a._to_send < b._to_send;
+		}
+	};
+
 	IPAddress _ip; // My address.
 
 	class LinkTableMulti *_link_table;
 	class ARPTableMulti *_arp_table;
 
+	// _seen is a ring of the last _max_seen_size floods, _seen[0] has id
+	// _seen_base and _seen_index maps (origin, seq) to ids.
 	Deque<Seen> _seen;
+	uint32_t _seen_base;
+	HashMap<SeenKey, uint32_t> _seen_index;
+	Vector<PendingForward> _pending;
+	Timer _forward_timer;
 
 	unsigned int _jitter; // msecs
+	unsigned int _batch; // msecs, forwards due this close share a timer run
 	int _max_seen_size; 
+
+	uint32_t _forward_batches;
+	uint32_t _forwards;
 	bool _debug;
 
 	static int write_handler(const String &, Element *, void *, ErrorHandler *);
 	static String read_handler(Element *, void *);
 
-	Packet * create_wing_packet(NodeAddress, NodeAddress, int, IPAddress, IPAddress, IPAddress, int, PathMulti, int);
+	Packet * create_wing_packet(NodeAddress, NodeAddress, int, IPAddress, IPAddress, IPAddress, int, const PathMulti &, int);
 
 	virtual void forward_seen(int, Seen *) = 0;
 
 	bool process_seen(T, int, bool);
 	void append_seen(T, int);
+	void clear_seen();
 	void forward_seen_hook();
 
-	static void static_forward_seen_hook(Timer *t, void *e) {
-		delete t; ((WINGBase *) e)->forward_seen_hook();
+	static void static_forward_seen_hook(Timer *, void *e) {
+		((WINGBase *) e)->forward_seen_hook();
 	}
 
 };
 
 template <typename T>
 WINGBase<T>::WINGBase() :
-	_link_table(0), _arp_table(0), _jitter(1000), _max_seen_size(100), _debug(false) {
+	_link_table(0), _arp_table(0), _seen_base(0),
+	_forward_timer(static_forward_seen_hook, this),
+	_jitter(1000), _batch(0), _max_seen_size(100),
+	_forward_batches(0), _forwards(0), _debug(false) {
 }
 
 template <typename T>
 WINGBase<T>::~WINGBase() {
 }
 
+template <typename T>
+int
+WINGBase<T>::initialize(ErrorHandler *) {
+	_forward_timer.initialize(this);
+	return 0;
+}
+
 template <typename T>
 void
 WINGBase<T>::forward_seen_hook() {
-	Timestamp now = Timestamp::now();
-	Vector<int> ifs = _link_table->get_local_interfaces();
-	_link_table->dijkstra(false);
-	for (int x = 0; x < _seen.size(); x++) {
-		if (_seen[x]._to_send < now && !_seen[x]._forwarded) {
-			for (int i = 0; i < ifs.size(); i++) {	
-				forward_seen(ifs[i], &_seen[x]);
-			}
-			_seen[x]._forwarded = true;
+	/* everything due within the next _batch msecs goes out now, so that
+	 * one route computation serves the whole batch */
+	Timestamp horizon = Timestamp::now() + Timestamp::make_msec(_batch);
+	Vector<int> ifs;
+	bool routed = false;
+	while (_pending.size() && _pending[0]._to_send <= horizon) {
+		uint32_t id = _pending[0]._id;
+		pop_heap(_pending.begin(), _pending.end(), pending_less());
+		_pending.pop_back();
+		/* the entry may have been evicted in the meantime */
+		if (id - _seen_base >= (uint32_t) _seen.size()) {
+			continue;
+		}
+		Seen *s = &_seen[id - _seen_base];
+		if (s->_forwarded) {
+			continue;
 		}
+		if (!routed) {
+			ifs = _link_table->get_local_interfaces();
+			_link_table->dijkstra(false);
+			_forward_batches++;
+			routed = true;
+		}
+		for (int i = 0; i < ifs.size(); i++) {
+			forward_seen(ifs[i], s);
+		}
+		s->_forwarded = true;
+		_forwards++;
+	}
+	if (_pending.size()) {
+		_forward_timer.schedule_at(_pending[0]._to_send);
 	}
 }
 
@@ -101,45 +176,57 @@ template <typename T>
 void
 WINGBase<T>::append_seen(T seen, int seq) {
 	if (_seen.size() >= _max_seen_size) {
+		SeenKey front(_seen.front()._seen, _seen.front()._seq);
+		uint32_t *id = _seen_index.findp(front);
+		if (id && *id == _seen_base) {
+			_seen_index.erase(front);
+		}
 		_seen.pop_front();
+		_seen_base++;
 	}
+	_seen_index.insert(SeenKey(seen, seq), _seen_base + _seen.size());
 	_seen.push_back(Seen(seen, seq));
 }
 
+template <typename T>
+void
+WINGBase<T>::clear_seen() {
+	_seen_base += _seen.size();
+	_seen.clear();
+	_seen_index.clear();
+	_pending.clear();
+	_forward_timer.unschedule();
+}
+
 template <typename T>
 bool
 WINGBase<T>::process_seen(T seen, int seq, bool schedule) {
-	int si = 0;
-	for (si = 0; si < _seen.size(); si++) {
-		if (seen == _seen[si]._seen && seq == _seen[si]._seq) {
-			_seen[si]._count++;
-			return false;
-		}
+	uint32_t *id = _seen_index.findp(SeenKey(seen, seq));
+	if (id) {
+		_seen[*id - _seen_base]._count++;
+		return false;
 	}
-	if (si == _seen.size()) {
-		if (_seen.size() >= _max_seen_size) {
-			_seen.pop_front();
-			si--;
-		}
-		_seen.push_back(Seen(seen, seq));
-	}		
-	_seen[si]._count++;
-	_seen[si]._when = Timestamp::now();
-	/* schedule timer */
+	append_seen(seen, seq);
+	Seen *s = &_seen.back();
+	s->_count++;
+	s->_when = Timestamp::now();
+	/* schedule forward */
 	if (schedule) {
 		int delay = click_random(1, _jitter);
-		_seen[si]._to_send = _seen[si]._when + Timestamp::make_msec(delay);
-		_seen[si]._forwarded = false;
-		Timer *t = new Timer(static_forward_seen_hook, (void *) this);
-		t->initialize(this);
-		t->schedule_after_msec(delay);
+		s->_to_send = s->_when + Timestamp::make_msec(delay);
+		s->_forwarded = false;
+		_pending.push_back(PendingForward(s->_to_send, _seen_base + _seen.size() - 1));
+		push_heap(_pending.begin(), _pending.end(), pending_less());
+		if (!_forward_timer.scheduled() || s->_to_send < _forward_timer.expiry()) {
+			_forward_timer.schedule_at(s->_to_send);
+		}
 	}
 	return true;
 }
 
 template <typename T>
 Packet *
-WINGBase<T>::create_wing_packet(NodeAddress src, NodeAddress dst, int type, IPAddress qdst, IPAddress netmask, IPAddress qsrc, int seq, PathMulti best, int next) {
+WINGBase<T>::create_wing_packet(NodeAddress src, NodeAddress dst, int type, IPAddress qdst, IPAddress netmask, IPAddress qsrc, int seq, const PathMulti &best, int next) {
 
 	if (!src) {
 		click_chatter("%{element} :: %s :: bad source address",
@@ -214,7 +301,7 @@ WINGBase<T>::create_wing_packet(NodeAddress src, NodeAddress dst, int type, IPAd
 }
 
 enum {
-	H_BASE_IP
+	H_BASE_IP, H_BASE_FORWARD_STATS
 };
 
 template <typename T>
@@ -224,6 +311,12 @@ WINGBase<T>::read_handler(Element *e, void *thunk) {
 	switch ((uintptr_t) thunk) {
 	case H_BASE_IP:
 		return td->_ip.unparse() + "\n";
+	case H_BASE_FORWARD_STATS: {
+		StringAccum sa;
+		sa << "batches " << td->_forward_batches << " forwards " << td->_forwards;
+		sa << " pending " << td->_pending.size() << "\n";
+		return sa.take_string();
+	}
 	default:
 		return String();
 	}
@@ -233,6 +326,7 @@ template <typename T>
 void
 WINGBase<T>::add_handlers() {
 	add_read_handler("ip", read_handler, H_BASE_IP);
+	add_read_handler("forward_stats", read_handler, H_BASE_FORWARD_STATS);
 }
 
 CLICK_ENDDECLS
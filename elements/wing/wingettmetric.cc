@@ -20,6 +20,20 @@
 #include "wingettmetric.hh"
 CLICK_DECLS
 
+unsigned WINGETTMetric::_backoff[3][12];
+
+void WINGETTMetric::static_initialize() {
+	unsigned a = 0, b = 0, n = 0;
+	for (int x = 0; x < 12; x++) {
+		a += calc_backoff(12, x);
+		b += calc_backoff(2, x);
+		n += calc_backoff_ht(0, x);
+		_backoff[PHY_A][x] = a;
+		_backoff[PHY_B][x] = b;
+		_backoff[PHY_N][x] = n;
+	}
+}
+
 WINGETTMetric::WINGETTMetric() :
 	WINGLinkMetric() {
 }
@@ -37,7 +51,7 @@ WINGETTMetric::cast(const char *n) {
 		return 0;
 }
 
-void WINGETTMetric::update_link(NodeAddress from, NodeAddress to, Vector<RateSize> rs, Vector<int> fwd, Vector<int> rev, uint32_t seq, uint32_t channel) {
+void WINGETTMetric::update_link(const NodeAddress &from, const NodeAddress &to, const LinkInfoView &rs, uint32_t seq, uint32_t channel) {
 
 	if (!from || !to) {
 		click_chatter("%{element} :: %s :: called with %s > %s", this,
@@ -62,23 +76,27 @@ void WINGETTMetric::update_link(NodeAddress from, NodeAddress to, Vector<RateSiz
 	int six_ack_size = 0;
 	int mcs1_ack_size = 0;
 
+	int rtype = rs.rtype();
+
 	for (int x = 0; x < rs.size(); x++) {
-		if (rs[x]._rtype == PROBE_TYPE_LEGACY) {
-			if (rs[x]._rate == 2 && (!one_ack_size || one_ack_size > rs[x]._size)) {
-				one_ack_size = rs[x]._size;
-				one_ack_fwd = fwd[x];
-				one_ack_rev = rev[x];
-			} else if (rs[x]._rate == 12 && (!six_ack_size || six_ack_size > rs[x]._size)) {
-				six_ack_size = rs[x]._size;
-				six_ack_fwd = fwd[x];
-				six_ack_rev = rev[x];
+		int rate = rs.rate(x);
+		int size = rs.probe_size(x);
+		if (rtype == PROBE_TYPE_LEGACY) {
+			if (rate == 2 && (!one_ack_size || one_ack_size > size)) {
+				one_ack_size = size;
+				one_ack_fwd = rs.fwd(x);
+				one_ack_rev = rs.rev(x);
+			} else if (rate == 12 && (!six_ack_size || six_ack_size > size)) {
+				six_ack_size = size;
+				six_ack_fwd = rs.fwd(x);
+				six_ack_rev = rs.rev(x);
 			} 
 		}
-		if (rs[x]._rtype == PROBE_TYPE_HT) {
-			if (rs[x]._rate == 1 && (!mcs1_ack_size || mcs1_ack_size > rs[x]._size)) {
-				mcs1_ack_size = rs[x]._size;
-				mcs1_ack_fwd = fwd[x];
-				mcs1_ack_rev = rev[x];
+		if (rtype == PROBE_TYPE_HT) {
+			if (rate == 1 && (!mcs1_ack_size || mcs1_ack_size > size)) {
+				mcs1_ack_size = size;
+				mcs1_ack_fwd = rs.fwd(x);
+				mcs1_ack_rev = rs.rev(x);
 			}
 		}
 	}
@@ -91,12 +109,14 @@ void WINGETTMetric::update_link(NodeAddress from, NodeAddress to, Vector<RateSiz
 	int fwd_metric = 0;
 
 	for (int x = 0; x < rs.size(); x++) {
+		int rate = rs.rate(x);
+		int size = rs.probe_size(x);
 		// probes smaller than 100 bytes are assumed to be ACKs
-		if (rs[x]._size >= 100) {
+		if (size >= 100) {
 			int ack_fwd = 0;
 			int ack_rev = 0;
-			if (rs[x]._rtype == PROBE_TYPE_LEGACY) {
-				if ((rs[x]._rate == 2) || (rs[x]._rate == 4) || (rs[x]._rate == 11) || (rs[x]._rate == 22)) {
+			if (rtype == PROBE_TYPE_LEGACY) {
+				if ((rate == 2) || (rate == 4) || (rate == 11) || (rate == 22)) {
 					ack_fwd = one_ack_fwd;
 					ack_rev = one_ack_rev;
 				} else {
@@ -108,13 +128,13 @@ void WINGETTMetric::update_link(NodeAddress from, NodeAddress to, Vector<RateSiz
 				ack_rev = mcs1_ack_rev;
 			}
 
-			int metric = compute_metric(ack_rev, fwd[x], rs[x]._rate, rs[x]._size, rs[x]._rtype);
+			int metric = compute_metric(ack_rev, rs.fwd(x), rate, size, rtype);
 
 			if (!fwd_metric || (metric && metric < fwd_metric)) {
 				fwd_metric = metric;
 			}
 
-			metric = compute_metric(ack_fwd, rev[x], rs[x]._rate, rs[x]._size, rs[x]._rtype);
+			metric = compute_metric(ack_fwd, rs.rev(x), rate, size, rtype);
 
 			if (!rev_metric || (metric && metric < rev_metric)) {
 				rev_metric = metric;
@@ -22,7 +22,49 @@ public:
 	void *cast(const char *);
 	const char *processing() const { return AGNOSTIC; }
 
-	inline unsigned compute_metric(int ack_prob, int data_prob, int data_rate, int data_size, int rtype) {
+	static void static_initialize();
+
+	static inline unsigned compute_metric(int ack_prob, int data_prob, int data_rate, int data_size, int rtype) {
+
+		if ((unsigned) ack_prob > 100 || (unsigned) data_prob > 100 || !data_rate || !data_size
+				|| (rtype == PROBE_TYPE_HT && (unsigned) data_rate >= 8)) {
+			return calc_metric(ack_prob, data_prob, data_rate, data_size, rtype);
+		}
+
+		unsigned retries = _retries[ack_prob][data_prob];
+
+		if (retries == 999999) {
+			return 999999;
+		}
+
+		/* the airtime of a try is the same for every retry, only the
+		 * backoff grows, and that is in the table */
+		unsigned per_try = 0;
+		const unsigned *backoff = 0;
+
+		if (rtype == PROBE_TYPE_HT) {
+			per_try = calc_transmit_time_ht(data_rate, data_size) + WIFI_SIFS_N + WIFI_ACK_N;
+			backoff = _backoff[PHY_N];
+		} else if (is_b_rate(data_rate)) {
+			per_try = calc_transmit_time(data_rate, data_size) + WIFI_SIFS_B + WIFI_ACK_B;
+			backoff = _backoff[PHY_B];
+		} else {
+			per_try = calc_transmit_time(data_rate, data_size) + WIFI_SIFS_A + WIFI_ACK_A;
+			backoff = _backoff[PHY_A];
+		}
+
+		unsigned tries = retries / 100;
+		unsigned low_usecs = (tries + 1) * per_try + backoff[tries];
+		unsigned high_usecs = (tries + 2) * per_try + backoff[tries + 1];
+
+		unsigned diff = retries % 100;
+		unsigned average = (diff * high_usecs + (100 - diff) * low_usecs) / 100;
+
+		return average;
+
+	}
+
+	static unsigned calc_metric(int ack_prob, int data_prob, int data_rate, int data_size, int rtype) {
 
 		if (!ack_prob || !data_prob || ack_prob < 30 || data_prob < 30) {
 			return 999999;
@@ -48,7 +90,15 @@ public:
 
 	}
 
-	void update_link(NodeAddress, NodeAddress, Vector<RateSize>, Vector<int> , Vector<int> , uint32_t , uint32_t);
+	void update_link(const NodeAddress &, const NodeAddress &, const LinkInfoView &, uint32_t, uint32_t);
+
+private:
+
+	enum { PHY_A, PHY_B, PHY_N };
+
+	/* cumulative backoff of the first n + 1 tries, for every number of
+	 * retries a delivery ratio of at least 30% can lead to */
+	static unsigned _backoff[3][12];
  
 };
 
@@ -37,9 +37,8 @@ WINGETXMetric::cast(const char *n) {
 		return 0;
 }
 
-void WINGETXMetric::update_link(NodeAddress from, NodeAddress to,
-		Vector<RateSize> rs, Vector<int> fwd,
-		Vector<int> rev, uint32_t seq, uint32_t channel) {
+void WINGETXMetric::update_link(const NodeAddress &from, const NodeAddress &to,
+		const LinkInfoView &rs, uint32_t seq, uint32_t channel) {
 
 	if (!from || !to) {
 		click_chatter("%{element} :: %s :: called with %s > %s", 
@@ -63,15 +62,17 @@ void WINGETXMetric::update_link(NodeAddress from, NodeAddress to,
 	int six_ack_size = 0;
 
 	for (int x = 0; x < rs.size(); x++) {
-		if (rs[x]._rate == 2 && (!one_ack_size || one_ack_size > rs[x]._size)) {
-			one_ack_size = rs[x]._size;
-			one_ack_fwd = fwd[x];
-			one_ack_rev = rev[x];
-		} else if (rs[x]._rate == 12 && (!six_ack_size || six_ack_size
-				> rs[x]._size)) {
-			six_ack_size = rs[x]._size;
-			six_ack_fwd = fwd[x];
-			six_ack_rev = rev[x];
+		int rate = rs.rate(x);
+		int size = rs.probe_size(x);
+		if (rate == 2 && (!one_ack_size || one_ack_size > size)) {
+			one_ack_size = size;
+			one_ack_fwd = rs.fwd(x);
+			one_ack_rev = rs.rev(x);
+		} else if (rate == 12 && (!six_ack_size || six_ack_size
+				> size)) {
+			six_ack_size = size;
+			six_ack_fwd = rs.fwd(x);
+			six_ack_rev = rs.rev(x);
 		}
 	}
 
@@ -83,21 +84,22 @@ void WINGETXMetric::update_link(NodeAddress from, NodeAddress to,
 	int fwd_metric = 0;
 
 	for (int x = 0; x < rs.size(); x++) {
-		if (rs[x]._size >= 100) {
+		int rate = rs.rate(x);
+		if (rs.probe_size(x) >= 100) {
 			int ack_rev = 0;
-			if ((rs[x]._rate == 2) || (rs[x]._rate == 4) || (rs[x]._rate == 11) || (rs[x]._rate == 22)) {
+			if ((rate == 2) || (rate == 4) || (rate == 11) || (rate == 22)) {
 				ack_rev = one_ack_rev;
 			} else {
 				ack_rev = six_ack_rev;
 			}
 
-			int metric = compute_metric(ack_rev, fwd[x]);
+			int metric = compute_metric(ack_rev, rs.fwd(x));
 
 			if (!fwd_metric || (metric && metric < fwd_metric)) {
 				fwd_metric = metric;
 			}
 
-			metric = compute_metric(ack_rev, fwd[x]);
+			metric = compute_metric(ack_rev, rs.fwd(x));
 
 			if (!rev_metric || (metric && metric < rev_metric)) {
 				rev_metric = metric;
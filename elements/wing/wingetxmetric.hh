@@ -22,14 +22,11 @@ public:
 	void *cast(const char *);
 	const char *processing() const { return AGNOSTIC; }
 
-	inline unsigned compute_metric(int ack_prob, int data_prob) {
-		if (!ack_prob || !data_prob || ack_prob < 30 || data_prob < 30) {
-			return 999999;
-		}
-		return 100 * 100 * 100 / (ack_prob * data_prob) - 100;
-	}	
-
-	void update_link(NodeAddress, NodeAddress, Vector<RateSize>, Vector<int> , Vector<int> , uint32_t , uint32_t);
+	static inline unsigned compute_metric(int ack_prob, int data_prob) {
+		return expected_retries(ack_prob, data_prob);
+	}
+
+	void update_link(const NodeAddress &, const NodeAddress &, const LinkInfoView &, uint32_t, uint32_t);
 
 };
 
@@ -23,7 +23,10 @@
 CLICK_DECLS
 
 WINGGatewaySelector::WINGGatewaySelector() :
-	_period(10000), _expire(30000), _timer(this) {
+	_rank_epoch(0), _rank_dirty(true), _period(10000), _expire(30000),
+	_timer(this), _trigger_timer(this), _reachable(0), _reachable_signature(0),
+	_trigger_pending(false), _periodic_ads(0), _triggered_ads(0),
+	_deferred_triggers(0) {
 	_seq = Timestamp::now().usec();
 }
 
@@ -32,53 +35,121 @@ WINGGatewaySelector::~WINGGatewaySelector() {
 
 int WINGGatewaySelector::configure(Vector<String> &conf, ErrorHandler *errh) {
 
-	return Args(conf, this, errh)
+	bool holddown = false;
+	if (Args(conf, this, errh)
 		.read_m("IP", _ip)
 		.read_m("LT", ElementCastArg("LinkTableMulti"), _link_table)
 		.read_m("ARP", ElementCastArg("ARPTableMulti"), _arp_table)
 		.read("PERIOD", _period)
 		.read("EXPIRE", _expire)
+		.read("HOLDDOWN", _holddown_min).read_status(holddown)
+		.read("BATCH", _batch)
 		.read("DEBUG", _debug)
-		.complete();
+		.complete() < 0) {
+		return -1;
+	}
+	if (!holddown) {
+		_holddown_min = _period / 10;
+	}
+	_holddown = _holddown_min;
+	return 0;
 
 }
 
-int WINGGatewaySelector::initialize(ErrorHandler *) {
+int WINGGatewaySelector::initialize(ErrorHandler *errh) {
+	if (WINGBase<HNAInfo>::initialize(errh) < 0) {
+		return -1;
+	}
 	_timer.initialize(this);
 	_timer.schedule_now();
+	_trigger_timer.initialize(this);
+	_link_table->add_route_listener(&_trigger_timer);
 	return 0;
 }
 
-void WINGGatewaySelector::run_timer(Timer *) {
+void WINGGatewaySelector::run_timer(Timer *t) {
+
+	if (t == &_trigger_timer) {
+		uint32_t reachable = _link_table->reachable_hosts();
+		uint32_t signature = _link_table->reachable_signature();
+		if (reachable != _reachable || signature != _reachable_signature) {
+			_reachable = reachable;
+			_reachable_signature = signature;
+			_trigger_pending = true;
+		}
+		if (_trigger_pending) {
+			trigger_ads();
+		}
+		return;
+	}
+
+	expire_gateways();
+
+	if (_hnas.size()) {
+		_periodic_ads++;
+	}
+	_trigger_pending = false;
+	send_ads();
+	schedule_ads();
 
-	// remove obsolete gateways
-	GWTable new_table;
+}
+
+void WINGGatewaySelector::expire_gateways() {
+	Vector<HNAInfo> expired;
 	Timestamp now = Timestamp::now();
+	Timestamp lifetime = Timestamp::make_msec(_expire);
 	for (GWIter iter = _gateways.begin(); iter.live(); iter++) {
-		GWInfo nfo = iter.value();
-		Timestamp expire = nfo._last_update + Timestamp::make_msec(_expire);
-		if (now < expire) {
-			new_table.insert(iter.key(), nfo);
+		if (!(now < iter.value()._last_update + lifetime)) {
+			expired.push_back(iter.key());
 		}
 	}
-	_gateways.clear();
-	for (GWIter iter = new_table.begin(); iter.live(); iter++) {
-		GWInfo nfo = iter.value();
-		_gateways.insert(iter.key(), nfo);
+	for (int x = 0; x < expired.size(); x++) {
+		_gateways.erase(expired[x]);
+	}
+	if (expired.size()) {
+		_rank_dirty = true;
 	}
+}
 
-	// send HNAs
+void WINGGatewaySelector::send_ads() {
 	Vector<int> ifs = _link_table->get_local_interfaces();
 	for (int i = 0; i < ifs.size(); i++) {
 		start_ad(ifs[i]);
 	}
 	_seq++;
+}
 
-	// schedule next transmission
+void WINGGatewaySelector::schedule_ads() {
 	unsigned max_jitter = _period / 10;
 	unsigned j = click_random(0, 2 * max_jitter);
 	_timer.schedule_after_msec(_period + j - max_jitter);
+}
 
+void WINGGatewaySelector::trigger_ads() {
+	if (!_hnas.size()) {
+		_trigger_pending = false;
+		return;
+	}
+	Timestamp now = Timestamp::now();
+	if (now < _next_trigger) {
+		/* changes made during the hold-down are announced at its end */
+		_trigger_pending = true;
+		_trigger_timer.schedule_at(_next_trigger);
+		_deferred_triggers++;
+		return;
+	}
+	/* the hold-down doubles while triggers keep coming */
+	if (now < _last_trigger + Timestamp::make_msec(_period)) {
+		_holddown = (2 * _holddown < _period) ? 2 * _holddown : _period;
+	} else {
+		_holddown = _holddown_min;
+	}
+	_last_trigger = now;
+	_next_trigger = now + Timestamp::make_msec(_holddown);
+	_trigger_pending = false;
+	_triggered_ads++;
+	send_ads();
+	schedule_ads();
 }
 
 void WINGGatewaySelector::start_ad(int iface) {
@@ -108,7 +179,7 @@ void WINGGatewaySelector::start_ad(int iface) {
 }
 
 void WINGGatewaySelector::forward_seen(int iface, Seen *s) {
-	PathMulti best = _link_table->best_route(s->_seen._gw, false);
+	const PathMulti &best = _link_table->cached_route(s->_seen._gw, false);
 	if (_debug) {
 		click_chatter("%{element} :: %s :: hna %s seq %d iface %u", 
 				this, 
@@ -132,22 +203,89 @@ void WINGGatewaySelector::forward_seen(int iface, Seen *s) {
 	output(0).push(p);
 }
 
+int WINGGatewaySelector::candidate_compar(const void *va, const void *vb, void *) {
+	const Candidate *a = (const Candidate *) va;
+	const Candidate *b = (const Candidate *) vb;
+	return (a->_metric < b->_metric) ? -1 : (a->_metric > b->_metric);
+}
+
+void WINGGatewaySelector::rank() {
+	_prefixes.clear();
+	_netmasks.clear();
+	for (GWTable::iterator iter = _gateways.begin(); iter.live(); iter++) {
+		GWInfo *nfo = &iter.value();
+		const PathMulti &p = _link_table->cached_route(nfo->_hna._gw, false);
+		uint32_t metric = _link_table->get_route_metric(p);
+		if (!metric) {
+			continue;
+		}
+		IPAddress nm = nfo->_hna._nm;
+		HNAInfo prefix = HNAInfo(nfo->_hna._dst & nm, nm, IPAddress());
+		Vector<Candidate> *ranked = _prefixes.findp(prefix);
+		if (!ranked) {
+			_prefixes.insert(prefix, Vector<Candidate>());
+			ranked = _prefixes.findp(prefix);
+			int x = 0;
+			while (x < _netmasks.size() && _netmasks[x] != nm) {
+				x++;
+			}
+			if (x == _netmasks.size()) {
+				_netmasks.push_back(nm);
+			}
+		}
+		Candidate c;
+		c._gw = nfo;
+		c._metric = metric;
+		ranked->push_back(c);
+	}
+	for (PrefixTable::iterator iter = _prefixes.begin(); iter.live(); iter++) {
+		Vector<Candidate> &ranked = iter.value();
+		click_qsort(ranked.begin(), ranked.size(), sizeof(Candidate), candidate_compar);
+	}
+	_rank_epoch = _link_table->route_epoch();
+	_rank_dirty = false;
+}
+
 IPAddress WINGGatewaySelector::best_gateway(IPAddress address) {
-	IPAddress best_gw = IPAddress();
-	int best_metric = 0;
+	bool fresh = false;
+	if (_rank_dirty || _rank_epoch != _link_table->route_epoch()) {
+		rank();
+		fresh = true;
+	}
+	IPAddress best_gw;
+	uint32_t best_metric;
 	Timestamp now = Timestamp::now();
-	for (GWIter iter = _gateways.begin(); iter.live(); iter++) {
-		GWInfo nfo = iter.value();
-		if (!nfo._hna.contains(address)) {
+	Timestamp lifetime = Timestamp::make_msec(_expire);
+ again:
+	best_gw = IPAddress();
+	best_metric = 0;
+	for (int x = 0; x < _netmasks.size(); x++) {
+		IPAddress nm = _netmasks[x];
+		Vector<Candidate> *ranked = _prefixes.findp(HNAInfo(address & nm, nm, IPAddress()));
+		if (!ranked) {
 			continue;
 		}
-		Timestamp expire = nfo._last_update + Timestamp::make_msec(_expire);
-		PathMulti p = _link_table->best_route(nfo._hna._gw, false);
-		int metric = _link_table->get_route_metric(p);
-		if (now < expire && metric && ((!best_metric) || best_metric > metric)) {
-			GWTable new_table;
-			best_gw = nfo._hna._gw;
-			best_metric = metric;
+		/* the best gateway for this prefix that is still announced */
+		for (int y = 0; y < ranked->size(); y++) {
+			const Candidate &c = ranked->at(y);
+			if (now < c._gw->_last_update + lifetime) {
+				/* damped metric updates and links worsening outside
+				 * the route trees do not move the route epoch, so
+				 * check the ranked metric is still current */
+				if (!fresh) {
+					const PathMulti &p = _link_table->cached_route(c._gw->_hna._gw, false);
+					if (_link_table->get_route_metric(p) != c._metric) {
+						rank();
+						fresh = true;
+						goto again;
+					}
+				}
+				if (!best_metric || best_metric > c._metric) {
+					best_gw = c._gw->_hna._gw;
+					best_metric = c._metric;
+				}
+				break;
+			}
 		}
 	}
 	return best_gw;
@@ -185,6 +323,7 @@ void WINGGatewaySelector::push(int, Packet *p_in) {
 	if (!nfo) {
 		_gateways.insert(hna, GWInfo(hna));
 		nfo = _gateways.findp(hna);
+		_rank_dirty = true;
 	}
 	nfo->_last_update = Timestamp::now();
 	nfo->_seen++;
@@ -195,11 +334,20 @@ void WINGGatewaySelector::push(int, Packet *p_in) {
 	return;
 }
 
+String WINGGatewaySelector::print_ad_stats() {
+	StringAccum sa;
+	sa << "periodic " << _periodic_ads;
+	sa << " triggered " << _triggered_ads;
+	sa << " deferred " << _deferred_triggers;
+	sa << " holddown " << _holddown << "\n";
+	return sa.take_string();
+}
+
 String WINGGatewaySelector::print_gateway_stats() {
 	StringAccum sa;
 	for (GWIter iter = _gateways.begin(); iter.live(); iter++) {
 		GWInfo nfo = iter.value();
-		PathMulti p = _link_table->best_route(nfo._hna._gw, false);
+		const PathMulti &p = _link_table->cached_route(nfo._hna._gw, false);
 		sa << nfo.unparse() << " ";
 		sa << "current_metric " << _link_table->get_route_metric(p) << "\n";
 	}
@@ -208,6 +356,7 @@ String WINGGatewaySelector::print_gateway_stats() {
 
 enum {
 	H_GATEWAY_STATS,
+	H_AD_STATS,
 	H_IS_GATEWAY,
 	H_HNAS,
 	H_HNA_ADD,
@@ -223,14 +372,21 @@ int WINGGatewaySelector::hna_add(IPAddress addr, IPAddress mask) {
 		}
 	}
 	_hnas.push_back(route);
+	_trigger_pending = true;
+	trigger_ads();
 	return 0;
 }
 
 int WINGGatewaySelector::hna_del(IPAddress addr, IPAddress mask) {
 	HNAInfo route = HNAInfo(addr, mask, _ip);
+	int size = _hnas.size();
 	for (Vector<HNAInfo>::iterator it = _hnas.begin(); it != _hnas.end();) {
 		(*it == route) ? it = _hnas.erase(it) : ++it;
 	}
+	if (_hnas.size() != size) {
+		_trigger_pending = true;
+		trigger_ads();
+	}
 	return 0;
 }
 
@@ -252,6 +408,8 @@ String WINGGatewaySelector::read_handler(Element *e, void *thunk) {
 	switch ((uintptr_t) thunk) {
 		case H_GATEWAY_STATS:
 			return f->print_gateway_stats();
+		case H_AD_STATS:
+			return f->print_ad_stats();
 		case H_HNAS: {
 			return f->hnas();
 		}
@@ -317,6 +475,7 @@ void WINGGatewaySelector::add_handlers() {
 	WINGBase<HNAInfo>::add_handlers();
 	add_read_handler("is_gateway", read_handler, (void *) H_IS_GATEWAY);
 	add_read_handler("gateway_stats", read_handler, (void *) H_GATEWAY_STATS);
+	add_read_handler("ad_stats", read_handler, (void *) H_AD_STATS);
 	add_read_handler("hnas", read_handler, (void *) H_HNAS);
 	add_write_handler("hna_add", write_handler, (void *) H_HNA_ADD);
 	add_write_handler("hna_del", write_handler, (void *) H_HNA_DEL);
@@ -6,7 +6,7 @@ CLICK_DECLS
 
 /*
  * =c
- * WINGGatewaySelector(IP, LT LinkTableMulti element, ARP ARPTableMulti element, [PERIOD], [EXPIRE], [DEBUG])
+ * WINGGatewaySelector(IP, LT LinkTableMulti element, ARP ARPTableMulti element, [PERIOD], [EXPIRE], [HOLDDOWN], [BATCH], [DEBUG])
  * =s Wifi, Wireless Routing
  * Select a gateway to send a packet to based on TCP 
  * connection state and metric to gateway.
@@ -15,6 +15,30 @@ CLICK_DECLS
  * Each gateway broadcasts an ad every PERIOD msec.  
  * Non-gateway nodes select the gateway with the best 
  * metric and forward ads.
+ *
+ * Known gateways are indexed by the prefix they announce, each prefix
+ * holding its gateways ranked by route metric. The ranking is redone
+ * when the routes in the link table are recomputed, when the set of
+ * gateways changes, or when the route metric of a gateway about to be
+ * selected no longer matches its rank, so selecting a gateway for a new
+ * flow usually takes one lookup per distinct netmask announced.
+ *
+ * Besides the periodic ads, a gateway advertises as soon as the set of
+ * hosts it has a route to or its HNAs change, so that new nodes learn
+ * about it without waiting a full PERIOD. Metric changes alone do not
+ * trigger ads. Triggered ads are throttled: after one is
+ * sent no other goes out for HOLDDOWN msec (default PERIOD/10), and the
+ * hold-down doubles, up to PERIOD, while changes keep coming. Changes made
+ * during a hold-down are announced together when it ends. A triggered ad
+ * also restarts the PERIOD timer.
+ *
+ * Ads forwarded by this node that fall due within BATCH msec of each other
+ * are sent together after a single route computation. BATCH defaults to 0,
+ * which forwards each ad at its own jittered time.
+ *
+ * =h ad_stats read
+ * Number of periodic and triggered ad rounds, triggers deferred by the
+ * hold-down and the current hold-down in msec.
  */
 
 // Host-Network Associations
@@ -73,6 +97,7 @@ public:
 
 	void push(int, Packet *);
 	void run_timer(Timer *);
+	String print_ad_stats();
 
 	void hnas_clear();
 	int hna_add(IPAddress, IPAddress);
@@ -139,6 +164,25 @@ private:
 	Vector<HNAInfo> _hnas;
 	GWTable _gateways;
 
+	// A gateway announcing a prefix, with its metric when last ranked
+	class Candidate {
+	public:
+		GWInfo *_gw;
+		uint32_t _metric;
+	};
+
+	// Gateways announcing the same prefix, best metric first; keyed by
+	// the prefix with the host bits and the gateway address cleared
+	typedef HashMap<HNAInfo, Vector<Candidate> > PrefixTable;
+
+	PrefixTable _prefixes;
+	Vector<IPAddress> _netmasks;
+	uint32_t _rank_epoch;
+	bool _rank_dirty;
+
+	void rank();
+	static int candidate_compar(const void *, const void *, void *);
+
 	class DynGW *_dyn_gw;
 
 	uint32_t _seq; // Next query sequence number to use.
@@ -148,6 +192,24 @@ private:
 
 	Timer _timer;
 
+	// throttling of the ads triggered by route and HNA changes
+	Timer _trigger_timer;
+	unsigned int _holddown_min; // msecs
+	unsigned int _holddown; // msecs
+	Timestamp _last_trigger;
+	Timestamp _next_trigger;
+	uint32_t _reachable; // reachable hosts when last checked
+	uint32_t _reachable_signature; // and their reachable_signature()
+	bool _trigger_pending;
+
+	uint32_t _periodic_ads;
+	uint32_t _triggered_ads;
+	uint32_t _deferred_triggers;
+
+	void expire_gateways();
+	void send_ads();
+	void trigger_ads();
+	void schedule_ads();
 	void start_ad(int);
 	void send(WritablePacket *);
 	void forward_seen(int, Seen *);
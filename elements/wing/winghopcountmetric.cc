@@ -37,9 +37,8 @@ WINGHopCountMetric::cast(const char *n) {
 		return 0;
 }
 
-void WINGHopCountMetric::update_link(NodeAddress from, NodeAddress to,
-		Vector<RateSize>, Vector<int>,
-		Vector<int>, uint32_t seq, uint32_t channel) {
+void WINGHopCountMetric::update_link(const NodeAddress &from, const NodeAddress &to,
+		const LinkInfoView &, uint32_t seq, uint32_t channel) {
 
 	if (!from || !to) {
 		click_chatter("%{element} :: %s :: called with %s > %s", 
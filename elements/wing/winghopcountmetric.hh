@@ -22,7 +22,7 @@ public:
 	void *cast(const char *);
 	const char *processing() const { return AGNOSTIC; }
 
-	void update_link(NodeAddress, NodeAddress, Vector<RateSize>, Vector<int> , Vector<int> , uint32_t , uint32_t);
+	void update_link(const NodeAddress &, const NodeAddress &, const LinkInfoView &, uint32_t, uint32_t);
 
 };
 
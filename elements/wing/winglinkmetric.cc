@@ -21,6 +21,16 @@
 #include <click/args.hh>
 CLICK_DECLS
 
+unsigned WINGLinkMetric::_retries[101][101];
+
+void WINGLinkMetric::static_initialize() {
+	for (int ack = 0; ack <= 100; ack++) {
+		for (int data = 0; data <= 100; data++) {
+			_retries[ack][data] = compute_retries(ack, data);
+		}
+	}
+}
+
 WINGLinkMetric::WINGLinkMetric() :
 	_link_table(0), _debug(false) {
 }
@@ -78,7 +88,7 @@ void WINGLinkMetric::update_link_table(NodeAddress from, NodeAddress to, uint32_
 
 }
 
-void WINGLinkMetric::update_link(NodeAddress, NodeAddress, Vector<RateSize>, Vector<int>, Vector<int>, uint32_t, uint32_t) {
+void WINGLinkMetric::update_link(const NodeAddress &, const NodeAddress &, const LinkInfoView &, uint32_t, uint32_t) {
 }
 
 ELEMENT_REQUIRES(bitrate LinkTableMulti)
@@ -6,6 +6,28 @@
 #include <elements/wifi/bitrate.hh>
 CLICK_DECLS
 
+/* the link_info array of a link_entry as found in a probe, read in
+ * place; the fwd rates may be overridden by locally measured ones */
+class LinkInfoView {
+public:
+	LinkInfoView(link_info *info, int n, int rtype, const int *fwd = 0) :
+		_info(info), _n(n), _rtype(rtype), _fwd(fwd) {
+	}
+
+	int size() const { return _n; }
+	int rtype() const { return _rtype; }
+	int rate(int x) const { return _info[x].rate(); }
+	int probe_size(int x) const { return _info[x].size(); }
+	int fwd(int x) const { return _fwd ? _fwd[x] : (int) _info[x].fwd(); }
+	int rev(int x) const { return _info[x].rev(); }
+
+private:
+	link_info *_info;
+	int _n;
+	int _rtype;
+	const int *_fwd;
+};
+
 class WINGLinkMetric: public Element {
 public:
 
@@ -17,7 +39,25 @@ public:
 
 	int configure(Vector<String> &, ErrorHandler *);
 
-	virtual void update_link(NodeAddress, NodeAddress, Vector<RateSize>, Vector<int>, Vector<int>, uint32_t, uint32_t);
+	static void static_initialize();
+
+	/* expected retransmissions, scaled by 100, of a link with the given
+	 * ack and data delivery ratios (in percent); 999999 if unusable */
+	static inline unsigned expected_retries(int ack_prob, int data_prob) {
+		if ((unsigned) ack_prob <= 100 && (unsigned) data_prob <= 100) {
+			return _retries[ack_prob][data_prob];
+		}
+		return compute_retries(ack_prob, data_prob);
+	}
+
+	static inline unsigned compute_retries(int ack_prob, int data_prob) {
+		if (!ack_prob || !data_prob || ack_prob < 30 || data_prob < 30) {
+			return 999999;
+		}
+		return 100 * 100 * 100 / (ack_prob * data_prob) - 100;
+	}
+
+	virtual void update_link(const NodeAddress &, const NodeAddress &, const LinkInfoView &, uint32_t, uint32_t);
 
 	void update_link_table(NodeAddress, NodeAddress, uint32_t, uint32_t, uint32_t, uint16_t);
 
@@ -26,6 +66,8 @@ protected:
 	class LinkTableMulti *_link_table;
 	bool _debug;
 
+	static unsigned _retries[101][101];
+
 };
 
 CLICK_ENDDECLS
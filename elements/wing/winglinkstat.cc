@@ -30,8 +30,9 @@ enum {
 WINGLinkStat::WINGLinkStat() :
 	_ads_rs_index(0), _neighbors_index(0), _neighbors_index_ht(0), 
 	_tau(100000), _period(10000),
-	_sent(0), _link_metric(0), _arp_table(0), _link_table(0),
+	_sent(0), _rtable(0), _rtable_ht(0), _link_metric(0), _arp_table(0), _link_table(0),
 	_timer(this), _debug(false) {
+	_ads_rates_version[0] = _ads_rates_version[1] = 0;
 }
 
 WINGLinkStat::~WINGLinkStat() {
@@ -85,6 +86,41 @@ int WINGLinkStat::configure(Vector<String> &conf, ErrorHandler *errh) {
 
 }
 
+void WINGLinkStat::build_templates() {
+	_templates.resize(_ads_rs.size());
+	for (int x = 0; x < _ads_rs.size(); x++) {
+		uint8_t *data = _templates[x]._data;
+		memset(data, 0, sizeof(_templates[x]._data));
+		click_ether *eh = (click_ether *) data;
+		memset(eh->ether_dhost, 0xff, 6);
+		memcpy(eh->ether_shost, _eth.data(), 6);
+		wing_probe *lp = (struct wing_probe *) (eh + 1);
+		lp->_type = WING_PT_PROBE;
+		lp->set_node(_node);
+		lp->set_channel(_channel);
+		lp->set_period(_period);
+		lp->set_tau(_tau);
+		lp->set_rate(_ads_rs[x]._rate);
+		lp->set_size(_ads_rs[x]._size);
+		lp->set_rtype(_ads_rs[x]._rtype);
+		lp->set_num_probes(_ads_rs.size());
+	}
+}
+
+const Vector<uint32_t> &WINGLinkStat::ads_rates(int rtype) {
+	int x = (rtype == PROBE_TYPE_HT) ? 1 : 0;
+	AvailableRates *rtable = (rtype == PROBE_TYPE_HT) ? _rtable_ht : _rtable;
+	if (_ads_rates_version[x] != rtable->version()) {
+		Vector<int> rates = rtable->lookup(_eth);
+		_ads_rates[x].resize(rates.size());
+		for (int y = 0; y < rates.size(); y++) {
+			_ads_rates[x][y] = htonl(rates[y]);
+		}
+		_ads_rates_version[x] = rtable->version();
+	}
+	return _ads_rates[x];
+}
+
 void WINGLinkStat::send_probe() {
 
 	_arp_table->insert(_node, _eth);
@@ -94,9 +130,14 @@ void WINGLinkStat::send_probe() {
 		return;
 	}
 
-	int size = _ads_rs[_ads_rs_index]._size;
-	int rate = _ads_rs[_ads_rs_index]._rate;
-	int rtype = _ads_rs[_ads_rs_index]._rtype;
+	if (_templates.size() != _ads_rs.size()) {
+		build_templates();
+	}
+
+	int index = _ads_rs_index;
+	int size = _ads_rs[index]._size;
+	int rate = _ads_rs[index]._rate;
+	int rtype = _ads_rs[index]._rtype;
 
 	_ads_rs_index = (_ads_rs_index + 1) % _ads_rs.size();
 	_sent++;
@@ -117,78 +158,36 @@ void WINGLinkStat::send_probe() {
 		return;
 	}
 
-	memset(p->data(), 0, p->length());
-	click_ether *eh = (click_ether *) p->data();
-	memset(eh->ether_dhost, 0xff, 6);
-	memcpy(eh->ether_shost, _eth.data(), 6);
+	memcpy(p->data(), _templates[index]._data, sizeof(_templates[index]._data));
 
 	wing_probe *lp = (struct wing_probe *) (p->data() + sizeof(click_ether));
 
-	lp->_type = WING_PT_PROBE;
-	lp->set_node(_node);
-	lp->set_channel(_channel);
-	lp->set_period(_period);
 	lp->set_seq(Timestamp::now().sec());
-	lp->set_tau(_tau);
 	lp->set_sent(_sent);
-	lp->set_rate(rate);
-	lp->set_size(size);
-	lp->set_rtype(rtype);
-	lp->set_num_probes(_ads_rs.size());
 
 	uint8_t *ptr = (uint8_t *) (lp + 1);
 	uint8_t *end = (uint8_t *) p->data() + p->length();
 
 	// rates entry
-	Vector<int> rates;
-	if (rtype == PROBE_TYPE_HT) {
-		rates = _rtable_ht->lookup(_eth);
-	} else {
-		rates = _rtable->lookup(_eth);
-	}
+	const Vector<uint32_t> &rates = ads_rates(rtype);
 	if (rates.size() && ptr + sizeof(rate_entry) * rates.size() < end) {
-		for (int x = 0; x < rates.size(); x++) {
-			rate_entry *r_entry = (struct rate_entry *) (ptr);
-			r_entry->set_rate(rates[x]);
-			ptr += sizeof(rate_entry);
-		}
+		memcpy(ptr, rates.begin(), sizeof(rate_entry) * rates.size());
+		ptr += sizeof(rate_entry) * rates.size();
 		lp->set_num_rates(rates.size());
 	}
 
 	// links_entry
+	Timestamp now = Timestamp::now();
+	Vector<ProbeList *> &neighbors = (rtype == PROBE_TYPE_HT) ? _neighbors_ht : _neighbors;
+	int &neighbors_index = (rtype == PROBE_TYPE_HT) ? _neighbors_index_ht : _neighbors_index;
 	int num_entries = 0;
-	// neighbors counter
-	int num_neighbors = 0;
-	while (ptr < end && num_entries < _neighbors.size() && num_neighbors < _neighbors.size()) {
-		ProbeList *probe;
-		if (rtype == PROBE_TYPE_HT) {
-			_neighbors_index_ht = (_neighbors_index_ht + 1) % _neighbors.size();
-			if (_neighbors_index_ht >= _neighbors.size()) {
-				break;
-			}
-			probe = _bcast_stats_ht.findp(_neighbors[_neighbors_index_ht]);
-		} else {
-			_neighbors_index = (_neighbors_index + 1) % _neighbors.size();
-			if (_neighbors_index >= _neighbors.size()) {
-				break;
-			}
-			probe = _bcast_stats.findp(_neighbors[_neighbors_index]);
-		}
-		if (!probe) {
-			if (_debug) {
-				click_chatter("%{element} :: %s :: lookup for %s failed", 
-						this,
-						__func__, 
-						_neighbors[_neighbors_index].unparse().c_str());	
-			}
-			num_neighbors++;
-			continue;
-		}
+	while (ptr < end && num_entries < neighbors.size()) {
+		neighbors_index = (neighbors_index + 1) % neighbors.size();
+		ProbeList *probe = neighbors[neighbors_index];
 		int size = probe->_probe_types.size() * sizeof(link_info) + sizeof(link_entry);
 		if (ptr + size > end) {
 			break;
 		}
-		num_neighbors++;
 		num_entries++;
 		link_entry *entry = (struct link_entry *) (ptr);
 		entry->set_node(probe->_node);
@@ -199,23 +198,22 @@ void WINGLinkStat::send_probe() {
 			entry->set_seq(lp->seq());
 		}
 		ptr += sizeof(link_entry);
-		Vector<int> fwd;
-		Vector<int> rev;
 		for (int x = 0; x < probe->_probe_types.size(); x++) {
 			RateSize rs = probe->_probe_types[x];
 			link_info *lnfo = (struct link_info *) (ptr + x * sizeof(link_info));
 			lnfo->set_size(rs._size);
 			lnfo->set_rate(rs._rate);
-			lnfo->set_fwd(probe->fwd_rate(rs._rate, rs._size));
-			lnfo->set_rev(probe->rev_rate(_start, rs._rate, rs._size));
-			fwd.push_back(lnfo->fwd());
-			rev.push_back(lnfo->rev());
+			lnfo->set_fwd(probe->fwd_rate(now, rs._rate, rs._size));
+			lnfo->set_rev(probe->rev_rate_at(now, _start, x));
 		}
 		ptr += probe->_probe_types.size() * sizeof(link_info);
 	}
 
 	lp->set_num_links(num_entries);
 
+	/* whatever is left of the probe is padding */
+	memset(ptr, 0, end - ptr);
+
 	struct click_wifi_extra *ceh = WIFI_EXTRA_ANNO(p);
 	ceh->magic = WIFI_EXTRA_MAGIC;
 	ceh->rate = rate;
@@ -280,11 +278,12 @@ WINGLinkStat::simple_action(Packet *p) {
 		if (lp->rtype() == PROBE_TYPE_HT) {
 			_bcast_stats_ht.insert(node, ProbeList(node, period, tau));
 			probe_list = _bcast_stats_ht.findp(node);
+			_neighbors_ht.push_back(probe_list);
 		} else {
 			_bcast_stats.insert(node, ProbeList(node, period, tau));
 			probe_list = _bcast_stats.findp(node);
+			_neighbors.push_back(probe_list);
 		}
-		_neighbors.push_back(node);
 		probe_list->_sent = 0;
 	} else if (probe_list->_period != period) {
 		if (_debug) {
@@ -295,7 +294,7 @@ WINGLinkStat::simple_action(Packet *p) {
 					probe_list->_period, 
 					period);
 		}
-		probe_list->_probes.clear();
+		probe_list->clear_probes();
 	} else if (probe_list->_tau != tau) {
 		if (_debug) {
 			click_chatter("%{element} :: %s :: %s has changed its link probe period from %u to %u; clearing probe info", 
@@ -305,7 +304,7 @@ WINGLinkStat::simple_action(Packet *p) {
 					probe_list->_tau, 
 					tau);
 		}
-		probe_list->_probes.clear();
+		probe_list->clear_probes();
 	} else if (probe_list->_sent > lp->sent()) {
 		if (_debug) {
 			click_chatter("%{element} :: %s :: %s has reset; clearing probe info",
@@ -313,7 +312,7 @@ WINGLinkStat::simple_action(Packet *p) {
 					__func__, 
 					node.unparse().c_str());
 		}
-		probe_list->_probes.clear();
+		probe_list->clear_probes();
 	}
 
 	Timestamp now = Timestamp::now();
@@ -324,14 +323,7 @@ WINGLinkStat::simple_action(Packet *p) {
 	probe_list->_sent = lp->sent();
 	probe_list->_last_rx = now;
 	probe_list->_num_probes = lp->num_probes();
-	probe_list->_probes.push_back(Probe(now, lp->rate(), lp->size(), lp->seq(), ceh->rssi, ceh->silence));
 	probe_list->_seq = lp->seq();
-	uint32_t window = 1 + (probe_list->_tau / 1000);
-
-	/* keep stats for at least the averaging period */
-	while (probe_list->_probes.size() && now.sec() - probe_list->_probes[0]._when.sec() > (signed) window) {
-		probe_list->_probes.pop_front();
-	}
 
 	int x = 0;
 	for (x = 0; x < probe_list->_probe_types.size(); x++) {
@@ -342,23 +334,28 @@ WINGLinkStat::simple_action(Packet *p) {
 	if (x == probe_list->_probe_types.size()) {
 		probe_list->_probe_types.push_back(rs);
 		probe_list->_fwd_rates.push_back(0);
+		probe_list->_windows.push_back(ProbeWindow());
 	}
+
+	/* keep stats for the averaging period */
+	ProbeWindow *window = probe_list->window(now, x);
+	window->push(Probe(now, lp->rate(), lp->size(), lp->seq(), ceh->rssi, ceh->silence));
 	uint8_t *ptr = (uint8_t *) (lp + 1);
 	uint8_t *end = (uint8_t *) p->data() + p->length();
 
 	// rates
 	int num_rates = lp->num_rates();
-	Vector<int> rates;
+	_rates.clear();
 	for (int x = 0; x < num_rates; x++) {
 		rate_entry *r_entry = (struct rate_entry *) (ptr);
-		rates.push_back(r_entry->rate());
+		_rates.push_back(r_entry->rate());
 		ptr += sizeof(rate_entry);
 	}
 
 	if (lp->rtype() == PROBE_TYPE_HT) {
-		_rtable_ht->insert(EtherAddress(eh->ether_shost), rates);
+		_rtable_ht->insert(EtherAddress(eh->ether_shost), _rates);
 	} else {
-		_rtable->insert(EtherAddress(eh->ether_shost), rates);
+		_rtable->insert(EtherAddress(eh->ether_shost), _rates);
 	}
 
 	// links
@@ -368,36 +365,22 @@ WINGLinkStat::simple_action(Packet *p) {
 		link_entry *entry = (struct link_entry *) (ptr);
 		NodeAddress neighbor = entry->node();
 		ptr += sizeof(struct link_entry);
-		Vector<RateSize> rates;
-		Vector<int> fwd;
-		Vector<int> rev;
-		for (uint8_t x = 0; x < entry->num_rates(); x++) {
-			struct link_info *nfo = (struct link_info *) (ptr + x * (sizeof(struct link_info)));
-			uint16_t nfo_size = nfo->size();
-			uint16_t nfo_rate = nfo->rate();
-			uint16_t nfo_fwd = nfo->fwd();
-			uint16_t nfo_rev = nfo->rev();
-			RateSize rs = RateSize(nfo_rate, nfo_size, lp->rtype());
-			/* update other link stuff */
-			rates.push_back(rs);
-			rev.push_back(nfo_rev);
-			if (neighbor == _node) {
-				fwd.push_back(probe_list->rev_rate(_start, rates[x]._rate, rates[x]._size));
-			} else {
-				fwd.push_back(nfo_fwd);
-			}
-			if (neighbor == _node) {
-				/* set the fwd rate */
-				for (int x = 0; x < probe_list->_probe_types.size(); x++) {
-					if (rs == probe_list->_probe_types[x]) {
-						probe_list->_fwd_rates[x] = nfo_rev;
-						break;
-					}
+		struct link_info *info = (struct link_info *) ptr;
+		if (neighbor == _node) {
+			/* our own link: use the locally measured fwd rates */
+			int fwd[256];
+			for (uint8_t x = 0; x < entry->num_rates(); x++) {
+				int t = probe_list->probe_type(info[x].rate(), info[x].size());
+				fwd[x] = probe_list->rev_rate_at(now, _start, t);
+				if (t >= 0) {
+					/* set the fwd rate */
+					probe_list->_fwd_rates[t] = info[x].rev();
 				}
 			}
+			_link_metric->update_link(node, neighbor, LinkInfoView(info, entry->num_rates(), lp->rtype(), fwd), entry->seq(), entry->channel());
+		} else {
+			_link_metric->update_link(node, neighbor, LinkInfoView(info, entry->num_rates(), lp->rtype()), entry->seq(), entry->channel());
 		}
-
-		_link_metric->update_link(node, neighbor, rates, fwd, rev, entry->seq(), entry->channel());
 		ptr += entry->num_rates() * sizeof(struct link_info);
 	}
 
@@ -408,52 +391,36 @@ WINGLinkStat::simple_action(Packet *p) {
 	return 0;
 }
 
-void WINGLinkStat::clear_stale()  {
-	Vector<NodeAddress> new_neighbors;
-	Timestamp now = Timestamp::now();
-	ProbeList *list;
-	for (int x = 0; x < _neighbors.size(); x++) {
-		NodeAddress node = _neighbors[x];
-		bool remove = false;
-		// clear legacy stats
-		list = _bcast_stats.findp(node);
-		if (list && (unsigned) now.sec() - list->_last_rx.sec() > 2 * list->_period / 1000) {
-			if (_debug) {
-				click_chatter("%{element} :: %s :: clearing stale neighbor %s age %u", 
-						this, 
-						__func__, 
-						node.unparse().c_str(),
-						now.sec() - list->_last_rx.sec());
-			}
-			_bcast_stats.remove(node);
-			remove = true;
-		}
-		// clear ht stats
-		list = _bcast_stats_ht.findp(node);
-		if (list && (unsigned) now.sec() - list->_last_rx.sec() > 2 * list->_period / 1000) {
+void WINGLinkStat::clear_stale(ProbeMap &stats, Vector<ProbeList *> &neighbors, const Timestamp &now) {
+	for (int x = neighbors.size() - 1; x >= 0; x--) {
+		ProbeList *list = neighbors[x];
+		if ((unsigned) now.sec() - list->_last_rx.sec() > 2 * list->_period / 1000) {
 			if (_debug) {
 				click_chatter("%{element} :: %s :: clearing stale neighbor %s age %u", 
 						this, 
 						__func__, 
-						node.unparse().c_str(),
+						list->_node.unparse().c_str(),
 						now.sec() - list->_last_rx.sec());
 			}
-			_bcast_stats_ht.remove(node);
-			remove = true;
-		} 
-		// keep the nighbor
-		if (!remove) {
-			new_neighbors.push_back(node);
+			neighbors[x] = neighbors.back();
+			neighbors.pop_back();
+			stats.remove(list->_node);
 		}
 	}
-	_neighbors.clear();
-	for (int x = 0; x < new_neighbors.size(); x++) {
-		_neighbors.push_back(new_neighbors[x]);
-	}
+}
+
+void WINGLinkStat::clear_stale()  {
+	Timestamp now = Timestamp::now();
+	// clear legacy stats
+	clear_stale(_bcast_stats, _neighbors, now);
+	// clear ht stats
+	clear_stale(_bcast_stats_ht, _neighbors_ht, now);
 }
 
 void WINGLinkStat::reset() {
 	_neighbors.clear();
+	_neighbors_ht.clear();
+	_templates.clear();
 	_bcast_stats.clear();
 	_bcast_stats_ht.clear();
 	_sent = 0;
@@ -508,10 +475,10 @@ String WINGLinkStat::print_stats(ProbeMap &stats, int type) {
 			}
 			int rate = _ads_rs[x]._rate;
 			int size = _ads_rs[x]._size;
-			int rev = pl->rev_rate(_start, rate, size);
-			int fwd = pl->fwd_rate(rate, size);
-			int rssi = pl->rev_rssi(rate, size);
-			int noise = pl->rev_noise(rate, size);
+			int rev = pl->rev_rate(now, _start, rate, size);
+			int fwd = pl->fwd_rate(now, rate, size);
+			int rssi = pl->rev_rssi(now, rate, size);
+			int noise = pl->rev_noise(now, rate, size);
 			sa << node.unparse().c_str();
 			EtherAddress eth_dest = _arp_table->lookup(node);
 			if (eth_dest && !eth_dest.is_broadcast()) {
@@ -596,6 +563,7 @@ int WINGLinkStat::write_handler(const String &in_s, Element *e, void *vparam, Er
 			}
 			f->_ads_rs.push_back(RateSize(rate, size, PROBE_TYPE_LEGACY));
 		}
+		f->_templates.clear();
 		break;
 	}
 	case H_HT_PROBES: {
@@ -615,6 +583,7 @@ int WINGLinkStat::write_handler(const String &in_s, Element *e, void *vparam, Er
 			}
 			f->_ads_rs.push_back(RateSize(rate, size, PROBE_TYPE_HT));
 		}
+		f->_templates.clear();
 		break;
 	}
 	}
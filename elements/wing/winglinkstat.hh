@@ -28,6 +28,37 @@ public:
 	uint32_t _noise;
 };
 
+/* probes of one rate and size received within the averaging period,
+ * with running sums so that the stats are read without a scan */
+class ProbeWindow {
+public:
+	ProbeWindow() : _rssi(0), _noise(0) {
+	}
+	Deque<Probe> _probes;
+	int _rssi;
+	int _noise;
+
+	void push(const Probe &probe) {
+		_probes.push_back(probe);
+		_rssi += probe._rssi;
+		_noise += probe._noise;
+	}
+
+	void expire(const Timestamp &earliest) {
+		while (_probes.size() && earliest > _probes.front()._when) {
+			_rssi -= _probes.front()._rssi;
+			_noise -= _probes.front()._noise;
+			_probes.pop_front();
+		}
+	}
+
+	void clear() {
+		_probes.clear();
+		_rssi = 0;
+		_noise = 0;
+	}
+};
+
 class ProbeList {
 public:
 	ProbeList() :
@@ -46,36 +77,50 @@ public:
 	uint32_t _seq;
 	Vector<RateSize> _probe_types;
 	Vector<int> _fwd_rates;
+	Vector<ProbeWindow> _windows; // most recently received probes, by type
 	Timestamp _last_rx;
-	Deque<Probe> _probes; // most recently received probes
 
-	int fwd_rate(int rate, int size) {
-		if (Timestamp::now() - _last_rx > Timestamp::make_msec(_tau)) {
-			return 0;
-		}
+	int probe_type(int rate, int size) {
 		for (int x = 0; x < _probe_types.size(); x++) {
 			if (_probe_types[x]._size == size && _probe_types[x]._rate == rate) {
-				return _fwd_rates[x];
+				return x;
 			}
 		}
-		return 0;
+		return -1;
 	}
 
-	int rev_rate(const Timestamp &start, int rate, int size) {
-		Timestamp now = Timestamp::now();
-		Timestamp earliest = now - Timestamp::make_msec(_tau);
-		if (_period == 0) {
+	void clear_probes() {
+		for (int x = 0; x < _windows.size(); x++) {
+			_windows[x].clear();
+		}
+	}
+
+	ProbeWindow *window(const Timestamp &now, int x) {
+		if (x < 0) {
 			return 0;
 		}
-		int num = 0;
-		for (int i = _probes.size() - 1; i >= 0; i--) {
-			if (earliest > _probes[i]._when) {
-				break;
-			}
-			if (_probes[i]._size == size && _probes[i]._rate == rate) {
-				num++;
-			}
+		_windows[x].expire(now - Timestamp::make_msec(_tau));
+		return &_windows[x];
+	}
+
+	int fwd_rate(const Timestamp &now, int rate, int size) {
+		if (now - _last_rx > Timestamp::make_msec(_tau)) {
+			return 0;
 		}
+		int x = probe_type(rate, size);
+		return (x < 0) ? 0 : _fwd_rates[x];
+	}
+
+	int rev_rate(const Timestamp &now, const Timestamp &start, int rate, int size) {
+		return rev_rate_at(now, start, probe_type(rate, size));
+	}
+
+	int rev_rate_at(const Timestamp &now, const Timestamp &start, int x) {
+		if (_period == 0) {
+			return 0;
+		}
+		ProbeWindow *w = window(now, x);
+		int num = w ? w->_probes.size() : 0;
 		Timestamp since_start = now - start;
 		uint32_t ms_since_start = WIFI_MAX(0, since_start.msecval());
 		uint32_t fake_tau = WIFI_MIN(_tau, ms_since_start);
@@ -90,50 +135,26 @@ public:
 		return WIFI_MIN(100, 100 * num / num_expected);
 	}
 
-	int rev_rssi(int rate, int size) {
-		Timestamp now = Timestamp::now();
-		Timestamp earliest = now - Timestamp::make_msec(_tau);
+	int rev_rssi(const Timestamp &now, int rate, int size) {
 		if (_period == 0) {
 			return 0;
 		}
-		int num = 0;
-		int sum = 0;
-		for (int i = _probes.size() - 1; i >= 0; i--) {
-			if (earliest > _probes[i]._when) {
-				break;
-			}
-			if (_probes[i]._size == size && _probes[i]._rate == rate) {
-				num++;
-				sum += _probes[i]._rssi;
-			}
-		}
-		if (!num) {
+		ProbeWindow *w = window(now, probe_type(rate, size));
+		if (!w || !w->_probes.size()) {
 			return -1;
 		}
-		return (sum / num);
+		return (w->_rssi / w->_probes.size());
 	}
 
-	int rev_noise(int rate, int size) {
-		Timestamp now = Timestamp::now();
-		Timestamp earliest = now - Timestamp::make_msec(_tau);
+	int rev_noise(const Timestamp &now, int rate, int size) {
 		if (_period == 0) {
 			return 0;
 		}
-		int num = 0;
-		int sum = 0;
-		for (int i = _probes.size() - 1; i >= 0; i--) {
-			if (earliest > _probes[i]._when) {
-				break;
-			}
-			if (_probes[i]._size == size && _probes[i]._rate == rate) {
-				num++;
-				sum += _probes[i]._noise;
-			}
-		}
-		if (!num) {
+		ProbeWindow *w = window(now, probe_type(rate, size));
+		if (!w || !w->_probes.size()) {
 			return -1;
 		}
-		return (sum / num);
+		return (w->_noise / w->_probes.size());
 	}
 };
 
@@ -162,16 +183,33 @@ private:
 	Vector<RateSize> _ads_rs;
 	int _ads_rs_index;
 
-	Vector<NodeAddress> _neighbors;
-	int _neighbors_index;
-	int _neighbors_index_ht;
-
 	typedef HashMap<NodeAddress, ProbeList> ProbeMap;
 	typedef ProbeMap::const_iterator ProbeIter;
 
 	ProbeMap _bcast_stats;
 	ProbeMap _bcast_stats_ht;
 
+	/* the probe lists in _bcast_stats and _bcast_stats_ht, in the
+	 * order they are advertised */
+	Vector<ProbeList *> _neighbors;
+	Vector<ProbeList *> _neighbors_ht;
+	int _neighbors_index;
+	int _neighbors_index_ht;
+
+	/* the Ethernet header and the fixed wing_probe fields of the
+	 * probe for each entry of _ads_rs */
+	class ProbeTemplate {
+	public:
+		uint8_t _data[sizeof(click_ether) + sizeof(wing_probe)];
+	};
+
+	Vector<ProbeTemplate> _templates;
+
+	/* our own rates as advertised, in network byte order, for legacy
+	 * and HT probes, and the AvailableRates version they came from */
+	Vector<uint32_t> _ads_rates[2];
+	uint32_t _ads_rates_version[2];
+
 	Timestamp _start;
 	NodeAddress _node;
 
@@ -187,6 +225,7 @@ private:
 
 	class AvailableRates *_rtable;
 	class AvailableRates *_rtable_ht;
+	Vector<int> _rates; // scratch for the rates advertised in a probe
 	class WINGLinkMetric *_link_metric;
 	class ARPTableMulti *_arp_table;
 	class LinkTableMulti *_link_table;
@@ -197,6 +236,9 @@ private:
 	void run_timer(Timer *);
 	void reset();
 	void clear_stale();
+	void clear_stale(ProbeMap &, Vector<ProbeList *> &, const Timestamp &);
+	void build_templates();
+	const Vector<uint32_t> &ads_rates(int);
 	void send_probe();
 
 	static int write_handler(const String &, Element *, void *, ErrorHandler *);
@@ -35,13 +35,14 @@ int WINGMetricFlood::configure(Vector<String> &conf, ErrorHandler *errh) {
 		.read_m("IP", _ip)
 		.read_m("LT", ElementCastArg("LinkTableMulti"), _link_table)
 		.read_m("ARP", ElementCastArg("ARPTableMulti"), _arp_table)
+		.read("BATCH", _batch)
 		.read("DEBUG", _debug)
 		.complete();
 
 }
 
 void WINGMetricFlood::forward_seen(int iface, Seen *s) {
-	PathMulti best = _link_table->best_route(s->_seen._src, false);
+	const PathMulti &best = _link_table->cached_route(s->_seen._src, false);
 	if (_debug) {
 		click_chatter("%{element} :: %s :: query %s seq %u iface %u", 
 				this,
@@ -99,7 +100,7 @@ void WINGMetricFlood::process_flood(Packet *p_in) {
 
 		if (process_seen(query, seq, false)) {
 
-			PathMulti best = _link_table->best_route(pk->qsrc(), false);
+			const PathMulti &best = _link_table->cached_route(pk->qsrc(), false);
 			if (!_link_table->valid_route(best)) {
 				click_chatter("%{element} :: %s :: invalid route %s", 
 						this,
@@ -130,7 +131,7 @@ void WINGMetricFlood::process_flood(Packet *p_in) {
 	return;
 }
 
-void WINGMetricFlood::start_reply(PathMulti best, uint32_t seq) {
+void WINGMetricFlood::start_reply(const PathMulti &best, uint32_t seq) {
 
 	int hops = best.size() - 1;
 	NodeAddress src = best[hops].arr();
@@ -242,7 +243,7 @@ int WINGMetricFlood::write_handler(const String &in_s, Element *e, void *vparam,
 	String s = cp_uncomment(in_s);
 	switch ((intptr_t) vparam) {
 		case H_CLEAR_SEEN: {
-			f->_seen.clear();
+			f->clear_seen();
 			break;
 		}
 	}
@@ -6,10 +6,13 @@ CLICK_DECLS
 
 /*
  * =c
- * WINGMetricFlood(IP, LT LinkTable element, ARP ARPTable element, [DEBUG])
+ * WINGMetricFlood(IP, LT LinkTable element, ARP ARPTable element, [BATCH], [DEBUG])
  * =s Wifi, Wireless Routing
  * =d
- * Floods route request messages
+ * Floods route request messages. Each forward is delayed by a random
+ * jitter; forwards falling due within BATCH msec of each other are sent
+ * together after a single route computation. BATCH defaults to 0, which
+ * sends each forward at its own jittered time.
  */
 
 // Query
@@ -29,6 +32,9 @@ public:
 		_dst(e._dst) ,
 		_src(e._src) { 
 	}
+	inline hashcode_t hashcode() const {
+		return CLICK_NAME(hashcode)(_dst) + CLICK_NAME(hashcode)(_src);
+	}
 	inline bool operator==(QueryInfo other) const {
 		return (other._dst == _dst && other._src == _src);
 	}
@@ -56,7 +62,7 @@ public:
 	void push(int, Packet *);
 
 	void start_query(IPAddress, int);
-	void start_reply(PathMulti, uint32_t);
+	void start_reply(const PathMulti &, uint32_t);
 
 private:
 
@@ -59,8 +59,8 @@ int WINGQuerier::configure(Vector<String> &conf, ErrorHandler *errh) {
 
 }
 
-Packet *
-WINGQuerier::encap(Packet *p_in, PathMulti best)
+bool
+WINGQuerier::build_header(const PathMulti &best, RouteHeader &header)
 {
 	if (best[0].dep()._ip != _ip) {
 		click_chatter("%{element} :: %s :: first hop %s doesn't match my ip %s", 
@@ -68,26 +68,22 @@ WINGQuerier::encap(Packet *p_in, PathMulti best)
 				__func__,
 				best[0].dep().unparse().c_str(), 
 				_ip.unparse().c_str());
-		p_in->kill();
-		return 0;
+		return false;
 	}
 
+	/* read the version first so that a concurrent update forces a rebuild */
+	header._arp_version = _arp_table->version();
+
 	int hops = best.size() - 1;
 	int len = wing_data::len_wo_data(hops);
-	int data_len = p_in->length();
 
-	WritablePacket *p = p_in->push(len + sizeof(click_ether));
-	if (p == 0) {
-		click_chatter("%{element} :: %s :: cannot encap packet!", this, __func__);
-		return 0;
-	}
+	header._bytes.resize(len + sizeof(click_ether));
+	memset(header._bytes.begin(), '\0', header._bytes.size());
 
-	click_ether *eh = (click_ether *) p->data();
+	click_ether *eh = (click_ether *) header._bytes.begin();
 	struct wing_data *pk = (struct wing_data *) (eh + 1);
-	memset(pk, '\0', len);
 
 	pk->_type = WING_PT_DATA;
-	pk->set_data_len(data_len);
 	pk->set_num_links(hops);
 
 	for (int i = 0; i < hops; i++) {
@@ -119,6 +115,34 @@ WINGQuerier::encap(Packet *p_in, PathMulti best)
 	memcpy(eh->ether_dhost, eth_dst.data(), 6);
 	memcpy(eh->ether_shost, eth_src.data(), 6);
 
+	return true;
+
+}
+
+Packet *
+WINGQuerier::encap(Packet *p_in, const PathMulti &best, RouteHeader &header)
+{
+	if (header._arp_version != _arp_table->version() || !header._bytes.size()) {
+		if (!build_header(best, header)) {
+			header.clear();
+			p_in->kill();
+			return 0;
+		}
+	}
+
+	int data_len = p_in->length();
+
+	WritablePacket *p = p_in->push(header._bytes.size());
+	if (p == 0) {
+		click_chatter("%{element} :: %s :: cannot encap packet!", this, __func__);
+		return 0;
+	}
+
+	memcpy(p->data(), header._bytes.begin(), header._bytes.size());
+
+	struct wing_data *pk = (struct wing_data *) (p->data() + sizeof(click_ether));
+	pk->set_data_len(data_len);
+
 	return p;
 
 }
@@ -187,9 +211,9 @@ void WINGQuerier::push(int, Packet *p_in) {
 		return;
 	}
 	/* look for static routes first */
-	PathMulti *p = _routes.findp(dst);
-	if (p) {
-		p_in = encap(p_in, *p);
+	StaticRoute *r = _routes.findp(dst);
+	if (r) {
+		p_in = encap(p_in, r->_p, r->_header);
 		if (p_in) {
 			output(0).push(p_in);
 		}
@@ -200,33 +224,29 @@ void WINGQuerier::push(int, Packet *p_in) {
 	if (!nfo) {
 		_queries.insert(dst, DstInfo(dst));
 		nfo = _queries.findp(dst);
-		nfo->_best_metric = 0;
-		nfo->_count = 0;
-		nfo->_p = PathMulti();
-		nfo->_last_query = Timestamp(0);
-		nfo->_last_switch = Timestamp(0);
-		nfo->_first_selected = Timestamp(0);
 	}
 	/* start a new query if the known one is too old */
 	Timestamp now = Timestamp::now();
 	Timestamp expire = nfo->_last_switch + _time_before_switch;
 	if (!nfo->_best_metric || !nfo->_p.size() || expire < now) {
-		PathMulti best = _link_table->best_route(dst, true);
+		const PathMulti &best = _link_table->cached_route(dst, true);
 		bool valid = _link_table->valid_route(best);
 		nfo->_last_switch.assign_now();
 		if (valid) {
 			if (nfo->_p != best) {
 				nfo->_first_selected.assign_now();
+				nfo->_p = best;
+				nfo->_header.clear();
 			}
-			nfo->_p = best;
 			nfo->_best_metric = _link_table->get_route_metric(best);
 		} else {
 			nfo->_p = PathMulti();
+			nfo->_header.clear();
 			nfo->_best_metric = 0;
 		}
 	}
 	if (nfo->_best_metric) {
-		p_in = encap(p_in, nfo->_p);
+		p_in = encap(p_in, nfo->_p, nfo->_header);
 		if (p_in) {
 			output(0).push(p_in);
 		}
@@ -252,7 +272,7 @@ String WINGQuerier::print_queries() {
 	Timestamp now = Timestamp::now();
 	for (DstTable::const_iterator iter = _queries.begin(); iter.live(); iter++) {
 		DstInfo dst = iter.value();
-		PathMulti best = _link_table->best_route(dst._ip, true);
+		const PathMulti &best = _link_table->cached_route(dst._ip, true);
 		int best_metric = _link_table->get_route_metric(best);
 		sa << dst._ip;
 		sa << " query_count " << dst._count;
@@ -272,7 +292,8 @@ String WINGQuerier::print_queries() {
 String WINGQuerier::print_routes() {
 	StringAccum sa;
 	for (RouteTable::iterator iter = _routes.begin(); iter.live(); iter++) {
-		sa << iter.key().unparse() << " hops " << iter.value().size() - 1 << " " << route_to_string(iter.value()) << "\n";
+		const PathMulti &p = iter.value()._p;
+		sa << iter.key().unparse() << " hops " << p.size() - 1 << " " << route_to_string(p) << "\n";
 	}
 	return sa.take_string();
 }
@@ -317,7 +338,7 @@ int WINGQuerier::write_handler(const String &in_s, Element *e, void *vparam,
 						p[0]._ip.unparse().c_str(),
 						td->_ip.unparse().c_str());
 		}
-		td->_routes.insert(p[p.size() - 1]._ip, p);
+		td->_routes.insert(p[p.size() - 1]._ip, StaticRoute(p));
 		break;
 	}
 	case H_DEL: {
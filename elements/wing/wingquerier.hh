@@ -14,6 +14,10 @@ CLICK_DECLS
  * found for a given packet and no valid route is found in the cache a
  * route request message is generated.
  *
+ * The Ethernet and source route headers are serialized once per route and
+ * copied in front of every packet sent along it. The copy is rebuilt when
+ * the route to the destination changes or when the ARP table changes.
+ *
  * =h add write
  * Writing "0:6.0.0.1;1 1:6.0.0.2:0" to this element will make all packets 
  * going from node 6.0.0.1 to node 6.0.0.2, use the first wireless interface
@@ -40,15 +44,30 @@ public:
 	String print_routes();
 
 	void push(int, Packet *);
-	Packet * encap(Packet *, PathMulti);
 	void encap(Packet *);
 
 private:
 
+	class RouteHeader {
+	public:
+		RouteHeader() : _arp_version(0) {}
+		uint32_t _arp_version; // ARP table version the header was built at
+		Vector<unsigned char> _bytes; // click_ether + wing_data, data_len unset
+		void clear() { _arp_version = 0; _bytes.clear(); }
+	};
+
+	class StaticRoute {
+	public:
+		StaticRoute() {}
+		StaticRoute(const PathMulti &p) : _p(p) {}
+		PathMulti _p;
+		RouteHeader _header;
+	};
+
 	class DstInfo {
 	public:
-		DstInfo() {}
-		DstInfo(IPAddress ip) : _ip(ip) {}
+		DstInfo() : _best_metric(0), _count(0) {}
+		DstInfo(IPAddress ip) : _ip(ip), _best_metric(0), _count(0) {}
 		IPAddress _ip;
 		int _best_metric;
 		int _count;
@@ -56,6 +75,7 @@ private:
 		PathMulti _p;
 		Timestamp _last_switch; // last time we picked a new best route
 		Timestamp _first_selected; // when _p was first selected as best route
+		RouteHeader _header; // serialized headers for _p
 	};
 
 	IPAddress _ip; // My address.
@@ -68,12 +88,15 @@ private:
 	typedef HashMap<IPAddress, DstInfo> DstTable;
 	DstTable _queries;
 
-	typedef HashMap<IPAddress, PathMulti> RouteTable;
+	typedef HashMap<IPAddress, StaticRoute> RouteTable;
 	RouteTable _routes;
 
 	Timestamp _query_wait;
 	Timestamp _time_before_switch;
 
+	bool build_header(const PathMulti &, RouteHeader &);
+	Packet * encap(Packet *, const PathMulti &, RouteHeader &);
+
 	static int write_handler(const String &, Element *, void *, ErrorHandler *);
 	static String read_handler(Element *, void *);
 
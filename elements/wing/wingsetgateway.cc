@@ -23,7 +23,8 @@
 CLICK_DECLS
 
 WINGSetGateway::WINGSetGateway() :
-	_timer(this), _period(60000) {
+	_timer(this), _period(60000), _burst(1024), _expired(0),
+	_expire_rate(0), _expired_mark(0) {
 }
 
 WINGSetGateway::~WINGSetGateway() {
@@ -37,6 +38,7 @@ int WINGSetGateway::configure(Vector<String> &conf, ErrorHandler *errh) {
 		.read("GW", _gw)
 		.read("SEL", ElementCastArg("WINGGatewaySelector"), _gw_sel)
 		.read("PERIOD", _period)
+		.read("BURST", _burst)
 		.read("DEBUG", _debug)
 		.complete();
 
@@ -44,6 +46,10 @@ int WINGSetGateway::configure(Vector<String> &conf, ErrorHandler *errh) {
 		return errh->error("Either GW or SEL must be specified!\n");
 	}
 
+	if (!_burst) {
+		return errh->error("BURST must be positive");
+	}
+
 	return ret;
 }
 
@@ -54,28 +60,66 @@ int WINGSetGateway::initialize(ErrorHandler *) {
 }
 
 void WINGSetGateway::run_timer(Timer *) {
+	Timestamp now = Timestamp::now();
 	// clean up flows
-	FlowTable new_table;
-	Timestamp timeout = Timestamp::make_msec(_period);
-	for (FTIter i = _flow_table.begin(); i.live(); i++) {
-		FlowTableEntry f = i.value();
-		if ((f.age() < timeout && ((f._fwd_alive) || f._rev_alive))) {
-			new_table.insert(f._id, f);
-		}
+	if (expire(now)) {
+		// more flows are due, carry on after the pending packets
+		_timer.schedule_now();
+		return;
 	}
-	_flow_table.clear();
-	for (FTIter i = new_table.begin(); i.live(); i++) {
-		FlowTableEntry f = i.value();
-		_flow_table.insert(f._id, f);
+	// update the expiry rate once per period
+	Timestamp elapsed = now - _expire_mark;
+	if (_expire_mark && elapsed.msecval() > 0) {
+		_expire_rate = (uint64_t) (_expired - _expired_mark) * 1000 / elapsed.msecval();
 	}
+	_expire_mark = now;
+	_expired_mark = _expired;
 	// re-schedule timer
 	_timer.schedule_after_msec(_period);
 }
 
+bool WINGSetGateway::expire(const Timestamp &now) {
+	Timestamp timeout = Timestamp::make_msec(_period);
+	for (uint32_t x = 0; x < _burst; x++) {
+		FlowTableEntry *f = _age.front();
+		if (!f || (now - f->_last_reply < timeout && !f->is_closed())) {
+			return false;
+		}
+		IPFlowID id = f->_id;
+		_age.pop_front();
+		_flow_table.erase(id);
+		_expired++;
+	}
+	return _age.front() != 0;
+}
+
+WINGSetGateway::FlowTableEntry *
+WINGSetGateway::insert_flow(const IPFlowID &flowid) {
+	FlowTableEntry *match = _flow_table.find_insert(flowid).get();
+	/* not answered yet, due at the next expiry */
+	_age.push_front(match);
+	return match;
+}
+
+void WINGSetGateway::replied(FlowTableEntry *match) {
+	match->saw_reply_packet();
+	if (!match->is_closed()) {
+		_age.erase(match);
+		_age.push_back(match);
+	}
+}
+
+void WINGSetGateway::closed(FlowTableEntry *match) {
+	if (match->is_closed()) {
+		_age.erase(match);
+		_age.push_front(match);
+	}
+}
+
 void WINGSetGateway::push_fwd(Packet *p_in) {
 	const click_tcp *tcph = p_in->tcp_header();
 	IPFlowID flowid = IPFlowID(p_in);
-	FlowTableEntry *match = _flow_table.findp(flowid);
+	FlowTableEntry *match = _flow_table.find(flowid).get();
 	if ((tcph->th_flags & TH_SYN) && match && match->is_pending()) {
 		match->_outstanding_syns++;
 		p_in->set_dst_ip_anno(match->_gw);
@@ -90,6 +134,7 @@ void WINGSetGateway::push_fwd(Packet *p_in) {
 			if (tcph->th_flags & TH_RST) {
 				match->_rev_alive = false; // rev flow is over
 			}
+			closed(match);
 			p_in->set_dst_ip_anno(match->_gw);
 			output(0).push(p_in);
 			return;
@@ -118,9 +163,7 @@ void WINGSetGateway::push_fwd(Packet *p_in) {
 		p_in->kill();
 		return;
 	}
-	_flow_table.insert(flowid, FlowTableEntry());
-	match = _flow_table.findp(flowid);
-	match->_id = flowid;
+	match = insert_flow(flowid);
 	match->_gw = gw;
 	match->saw_forward_packet();
 	match->_outstanding_syns++;
@@ -131,7 +174,7 @@ void WINGSetGateway::push_fwd(Packet *p_in) {
 void WINGSetGateway::push_rev(Packet *p_in) {
 	const click_tcp *tcph = p_in->tcp_header();
 	IPFlowID flowid = IPFlowID(p_in).reverse();
-	FlowTableEntry *match = _flow_table.findp(flowid);
+	FlowTableEntry *match = _flow_table.find(flowid).get();
 	if ((tcph->th_flags & TH_SYN) && (tcph->th_flags & TH_ACK)) {
 		if (match) {
 			if (match->_gw != MISC_IP_ANNO(p_in)) {
@@ -143,7 +186,7 @@ void WINGSetGateway::push_rev(Packet *p_in) {
 				p_in->kill();
 				return;
 			}
-			match->saw_reply_packet();
+			replied(match);
 			match->_outstanding_syns = 0;
 			output(1).push(p_in);
 			return;
@@ -154,13 +197,14 @@ void WINGSetGateway::push_rev(Packet *p_in) {
 	}
 	/* not a syn-ack packet */
 	if (match) {
-		match->saw_reply_packet();
 		if (tcph->th_flags & (TH_FIN | TH_RST)) {
 			match->_rev_alive = false;
 		}
 		if (tcph->th_flags & TH_RST) {
 			match->_fwd_alive = false;
 		}
+		replied(match);
+		closed(match);
 		output(1).push(p_in);
 		return;
 	}
@@ -168,11 +212,9 @@ void WINGSetGateway::push_rev(Packet *p_in) {
 			this, 
 			__func__, 
 			flowid.unparse().c_str());
-	_flow_table.insert(flowid, FlowTableEntry());
-	match = _flow_table.findp(flowid);
-	match->_id = flowid;
+	match = insert_flow(flowid);
 	match->_gw = MISC_IP_ANNO(p_in);
-	match->saw_reply_packet();
+	replied(match);
 	output(1).push(p_in);
 	return;
 }
@@ -231,14 +273,14 @@ void WINGSetGateway::push(int port, Packet *p_in) {
 String WINGSetGateway::print_flows() {
 	StringAccum sa;
 	for (FTIter iter = _flow_table.begin(); iter.live(); iter++) {
-		FlowTableEntry f = iter.value();
+		FlowTableEntry f = *iter;
 		sa << f._id << " gw " << f._gw << " age " << f.age() << "\n";
 	}
 	return sa.take_string();
 }
 
 enum {
-	H_GATEWAY, H_FLOWS
+	H_GATEWAY, H_FLOWS, H_FLOW_COUNT, H_EXPIRED, H_EXPIRE_RATE, H_LOAD_FACTOR
 };
 
 String WINGSetGateway::read_handler(Element *e, void *thunk) {
@@ -249,6 +291,14 @@ String WINGSetGateway::read_handler(Element *e, void *thunk) {
 					: c->_gw_sel->best_gateway().unparse() + "\n";
 		case H_FLOWS:
 			return c->print_flows();
+		case H_FLOW_COUNT:
+			return String(c->_flow_table.size()) + "\n";
+		case H_EXPIRED:
+			return String(c->_expired) + "\n";
+		case H_EXPIRE_RATE:
+			return String(c->_expire_rate) + "\n";
+		case H_LOAD_FACTOR:
+			return String((double) c->_flow_table.size() / c->_flow_table.bucket_count()) + "\n";
 		default:
 			return "<error>\n";
 	}
@@ -275,6 +325,10 @@ int WINGSetGateway::write_handler(const String &in_s, Element *e, void *vparam,
 
 void WINGSetGateway::add_handlers() {
 	add_read_handler("flows", read_handler, H_FLOWS);
+	add_read_handler("flow_count", read_handler, H_FLOW_COUNT);
+	add_read_handler("expired", read_handler, H_EXPIRED);
+	add_read_handler("expire_rate", read_handler, H_EXPIRE_RATE);
+	add_read_handler("load_factor", read_handler, H_LOAD_FACTOR);
 	add_read_handler("gateway", read_handler, H_GATEWAY);
 	add_write_handler("gateway", write_handler, H_GATEWAY);
 }
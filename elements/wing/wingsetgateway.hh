@@ -3,16 +3,36 @@
 #include <click/element.hh>
 #include "wingbase.hh"
 #include <click/ipflowid.hh>
+#include <click/hashtable.hh>
+#include <click/list.hh>
 #include <clicknet/tcp.h>
 CLICK_DECLS
 
 /*
  * =c
- * WINGSetGateway([PERIOD], [DEBUG])
+ * WINGSetGateway([PERIOD], [BURST], [DEBUG])
  * =s Wifi, Wireless Routing
  * WINGSetGateway a TCP flow current default route.
  * =d
  * This element marks the gateway for a packet to be sent to.
+ *
+ * TCP flows are remembered until PERIOD msecs (default 60000) have passed
+ * without a reply, or until both directions have been closed. Flows are
+ * kept in the order they were last answered, so each expiry pass only
+ * looks at the flows that actually expire. A pass expires at most BURST
+ * flows (default 1024) and continues right away if more are due.
+ * =h flows read-only
+ * The TCP flows and the gateway each one is bound to.
+ * =h flow_count read-only
+ * Number of TCP flows.
+ * =h expired read-only
+ * Number of flows expired so far.
+ * =h expire_rate read-only
+ * Flows expired per second, measured over the last expiry period.
+ * =h load_factor read-only
+ * Flows per bucket of the flow table.
+ * =h gateway read/write
+ * The gateway, if fixed, or the best gateway otherwise.
  */
 
 class WINGSetGateway: public Element {
@@ -40,6 +60,8 @@ private:
 
 	class FlowTableEntry {
 	public:
+		typedef IPFlowID key_type;
+		typedef const IPFlowID &key_const_reference;
 		class IPFlowID _id;
 		IPAddress _gw;
 		Timestamp _oldest_unanswered;
@@ -48,7 +70,9 @@ private:
 		bool _fwd_alive;
 		bool _rev_alive;
 		bool _all_answered;
-		FlowTableEntry() {
+		List_member<FlowTableEntry> _age_link;
+		FlowTableEntry(const IPFlowID &id) :
+			_id(id), _outstanding_syns(0) {
 			_all_answered = true;
 			_fwd_alive = true;
 			_rev_alive = true;
@@ -59,6 +83,9 @@ private:
 			_fwd_alive(e._fwd_alive), _rev_alive(e._rev_alive), 
 			_all_answered(e._all_answered) {
 		}
+		key_const_reference hashkey() const {
+			return _id;
+		}
 		void saw_forward_packet() {
 			if (_all_answered) {
 				_oldest_unanswered = Timestamp::now();
@@ -73,20 +100,39 @@ private:
 		bool is_pending() const {
 			return (_outstanding_syns > 0);
 		}
+		bool is_closed() const {
+			return (!_fwd_alive && !_rev_alive);
+		}
 		Timestamp age() {
 			return Timestamp::now() - _last_reply;
 		}
 	};
 
-	typedef HashMap<IPFlowID, FlowTableEntry> FlowTable;
+	typedef HashTable<FlowTableEntry> FlowTable;
 	typedef FlowTable::const_iterator FTIter;
 	FlowTable _flow_table;
 
+	/* flows by time of the last reply; flows never answered or closed
+	 * in both directions are at the front, and expire first */
+	typedef List<FlowTableEntry, &FlowTableEntry::_age_link> AgeList;
+	AgeList _age;
+
 	IPAddress _gw;
 	Timer _timer;
 	uint32_t _period;
+	uint32_t _burst;
 	bool _debug;
 
+	uint32_t _expired;
+	uint32_t _expire_rate;
+	uint32_t _expired_mark;
+	Timestamp _expire_mark;
+
+	FlowTableEntry *insert_flow(const IPFlowID &);
+	void replied(FlowTableEntry *);
+	void closed(FlowTableEntry *);
+	bool expire(const Timestamp &);
+
 	class WINGGatewaySelector *_gw_sel;
 
 	void push_fwd(Packet *);
@@ -339,6 +339,7 @@ class Timer { public:
   private:
 
     int _schedpos1;
+    int _wheelpos;
     Timestamp _expiry_s;
     union {
 	TimerCallback callback;
@@ -12,6 +12,7 @@ class Timer;
 class TimerSet { public:
 
     TimerSet();
+    ~TimerSet();
 
     Timestamp timer_expiry_steady() const	{ return _timer_expiry; }
     inline Timestamp timer_expiry_steady_adjusted() const;
@@ -19,12 +20,16 @@ class TimerSet { public:
     inline int next_timer_delay(bool more_tasks, Timestamp &t) const;
 #endif
 
-    Timer *next_timer();			// useful for benchmarking
+    Timer *next_timer();			// useful for benchmarking;
+						// approximate with the wheel
 
     unsigned max_timer_stride() const		{ return _max_timer_stride; }
     unsigned timer_stride() const		{ return _timer_stride; }
     void set_max_timer_stride(unsigned timer_stride);
 
+    bool timer_wheel() const			{ return _wheel_slots; }
+    void set_timer_wheel(bool wheel);
+
     void kill_router(Router *router);
 
     void run_timers(RouterThread *thread, Master *master);
@@ -71,6 +76,24 @@ class TimerSet { public:
     Timestamp _timer_check;
     uint32_t _timer_check_reports;
 
+    // Optional hashed hierarchical timing wheel.  Timers due within the
+    // current millisecond tick live in _timer_heap as usual; later ones wait
+    // in wheel slots and move to the heap when their tick comes up.
+    enum {
+	wheel_bits0 = 8, wheel_bits = 6, wheel_levels = 4,
+	wheel_nslots = (1 << wheel_bits0) + (wheel_levels - 1) * (1 << wheel_bits) + 1,
+	wheel_overflow = wheel_nslots - 1,
+	wheel_nwords = wheel_overflow / 32,
+	wheel_schedpos1 = -0x40000000	// _schedpos1 <= this: in the wheel
+    };
+    Vector<Timer *> *_wheel_slots;
+    Vector<Timer *> _wheel_cascade;
+    uint32_t _wheel_bits[wheel_nwords];
+    unsigned _wheel_count;
+    Timestamp::value_type _wheel_now;	// last tick moved to _timer_heap
+    Timestamp::value_type _wheel_due;	// lower bound on next nonempty tick
+    Timestamp _wheel_expiry;		// _wheel_due as a Timestamp, or 0
+
     inline void run_one_timer(Timer *);
 
     void set_timer_expiry() {
@@ -78,9 +101,23 @@ class TimerSet { public:
 	    _timer_expiry = _timer_heap.unchecked_at(0).expiry_s;
 	else
 	    _timer_expiry = Timestamp();
+	if (_wheel_expiry && (!_timer_expiry || _wheel_expiry < _timer_expiry))
+	    _timer_expiry = _wheel_expiry;
     }
     void check_timer_expiry(Timer *t);
 
+    static bool wheel_scheduled(int schedpos1) {
+	return schedpos1 <= wheel_schedpos1;
+    }
+    inline void heap_insert(Timer *t);
+    void wheel_insert(Timer *t, Timestamp::value_type tick);
+    void wheel_remove(Timer *t);
+    void wheel_place(Timer *t);
+    bool wheel_schedule(Timer *t);
+    void wheel_cascade(int slot);
+    void wheel_advance(Timestamp::value_type target);
+    Timestamp::value_type wheel_next_due(int *slotp) const;
+
     inline void lock_timers();
     inline bool attempt_lock_timers();
     inline void unlock_timers();
@@ -154,6 +191,12 @@ TimerSet::next_timer()
 {
     lock_timers();
     Timer *t = _timer_heap.empty() ? 0 : _timer_heap.unchecked_at(0).t;
+    if (!t && _wheel_count) {
+	// approximate: some timer from the first nonempty wheel slot
+	int slot;
+	(void) wheel_next_due(&slot);
+	t = _wheel_slots[slot].front();
+    }
     unlock_timers();
     return t;
 }
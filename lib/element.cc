@@ -1714,7 +1714,8 @@ Element::selected(int fd)
 /** @brief Register interest in @a mask events on file descriptor @a fd.
  *
  * @param fd the file descriptor
- * @param mask relevant events: bitwise-or of one or more of SELECT_READ, SELECT_WRITE
+ * @param mask relevant events: bitwise-or of one or more of SELECT_READ, SELECT_WRITE,
+ * optionally with SELECT_EDGE
  *
  * Click will register interest in readability and/or writability on file
  * descriptor @a fd.  When @a fd is ready, Click will call this element's
@@ -1724,6 +1725,14 @@ Element::selected(int fd)
  * @a fd and events in @a mask.  However, different elements may register
  * interest in different events for the same @a fd.
  *
+ * If @a mask includes SELECT_EDGE, the element promises that selected()
+ * drains @a fd completely, reading (or writing) until the call would block.
+ * Click may then use edge-triggered notification (epoll's EPOLLET), which
+ * calls selected() only when new data arrives rather than on every
+ * iteration while data remains.  SELECT_EDGE takes effect only if every
+ * event registered on @a fd requests it, and it is ignored by the select,
+ * poll, and kqueue backends, which always use level-triggered notification.
+ *
  * @note Only available at user level.
  *
  * @note Selecting for writability with SELECT_WRITE normally requires more
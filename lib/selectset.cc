@@ -33,6 +33,9 @@
 #  define EV_SET_UDATA_CAST	/* nothing */
 # endif
 #endif
+#if HAVE_ALLOW_EPOLL
+# include <sys/epoll.h>
+#endif
 CLICK_DECLS
 
 namespace {
@@ -57,6 +60,9 @@ SelectSet::SelectSet()
     _kqueue = kqueue();
 # endif
 #endif
+#if HAVE_ALLOW_EPOLL
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+#endif
 
 #if !HAVE_ALLOW_POLL
     FD_ZERO(&_read_select_fd_set);
@@ -85,6 +91,10 @@ SelectSet::~SelectSet()
 #if HAVE_ALLOW_KQUEUE
     if (_kqueue >= 0)
 	close(_kqueue);
+#endif
+#if HAVE_ALLOW_EPOLL
+    if (_epoll >= 0)
+	close(_epoll);
 #endif
     if (_wake_pipe[0] >= 0) {
 	close(_wake_pipe[0]);
@@ -100,7 +110,8 @@ SelectSet::initialize()
 	fcntl(_wake_pipe[1], F_SETFL, O_NONBLOCK);
 	fcntl(_wake_pipe[0], F_SETFD, FD_CLOEXEC);
 	fcntl(_wake_pipe[1], F_SETFD, FD_CLOEXEC);
-	register_select(_wake_pipe[0], true, false);
+	// post_select() drains the wake pipe completely
+	register_select(_wake_pipe[0], true, false, true);
     }
     assert(_wake_pipe[0] >= 0);
 }
@@ -125,8 +136,36 @@ SelectSet::kill_router(Router *router)
     unlock();
 }
 
+#if HAVE_ALLOW_EPOLL
+void
+SelectSet::update_epoll(int fd, int old_events, int events)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    if (events & POLLIN)
+	ev.events |= EPOLLIN;
+    if (events & POLLOUT)
+	ev.events |= EPOLLOUT;
+    if (events && (_selinfo[fd].edge & events) == events)
+	ev.events |= EPOLLET;
+    ev.data.fd = fd;
+
+    int op = !old_events ? EPOLL_CTL_ADD : (events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL);
+    if (epoll_ctl(_epoll, op, fd, &ev) < 0) {
+	// An fd closed before its remove_select() has already left the
+	// epoll set.
+	if (op == EPOLL_CTL_DEL)
+	    return;
+	// Not all file descriptors are epollable (regular files are not).
+	// So if we encounter a problem, fall back to select() or poll().
+	close(_epoll);
+	_epoll = -1;
+    }
+}
+#endif
+
 void
-SelectSet::register_select(int fd, bool add_read, bool add_write)
+SelectSet::register_select(int fd, bool add_read, bool add_write, bool edge)
 {
     // add the pollfd
     if (fd >= _selinfo.size())
@@ -138,12 +177,23 @@ SelectSet::register_select(int fd, bool add_read, bool add_write)
 	_pollfds.back().events = 0;
     }
     int pi = _selinfo[fd].pollfd;
+    int old_events = _pollfds[pi].events;
 
     // add the elements
     if (add_read)
 	_pollfds[pi].events |= POLLIN;
     if (add_write)
 	_pollfds[pi].events |= POLLOUT;
+    int edge_events = (add_read ? POLLIN : 0) | (add_write ? POLLOUT : 0);
+    if (edge)
+	_selinfo[fd].edge |= edge_events;
+    else
+	_selinfo[fd].edge &= ~edge_events;
+
+#if HAVE_ALLOW_EPOLL
+    if (_epoll >= 0)
+	update_epoll(fd, old_events, _pollfds[pi].events);
+#endif
 
 #if HAVE_ALLOW_KQUEUE
     if (_kqueue >= 0) {
@@ -201,7 +251,7 @@ SelectSet::add_select(int fd, Element *element, int mask)
 	return -1;
     if (mask == 0)
 	return 0;
-    assert(element && (mask & ~(SELECT_READ | SELECT_WRITE)) == 0);
+    assert(element && (mask & ~(SELECT_READ | SELECT_WRITE | Element::SELECT_EDGE)) == 0);
     lock();
 
     // check whether to add readability, writability, or both; it is an error
@@ -228,7 +278,7 @@ SelectSet::add_select(int fd, Element *element, int mask)
     }
 
     // add the pollfd
-    register_select(fd, add_read, add_write);
+    register_select(fd, add_read, add_write, mask & Element::SELECT_EDGE);
 
     // add the elements
     if (add_read)
@@ -252,12 +302,19 @@ SelectSet::remove_pollfd(int pi, int event)
 
     // remove event
     int fd = _pollfds[pi].fd;
+    int old_events = _pollfds[pi].events;
     _pollfds[pi].events &= ~event;
+    _selinfo[fd].edge &= ~event;
     if (event == POLLIN)
 	_selinfo[fd].read = 0;
     else
 	_selinfo[fd].write = 0;
 
+#if HAVE_ALLOW_EPOLL
+    if (_epoll >= 0 && old_events != _pollfds[pi].events)
+	update_epoll(fd, old_events, _pollfds[pi].events);
+#endif
+
 #if HAVE_ALLOW_KQUEUE
     // remove event from kqueue
     if (_kqueue >= 0) {
@@ -302,7 +359,7 @@ SelectSet::remove_select(int fd, Element *element, int mask)
 {
     if (fd < 0)
 	return -1;
-    assert(element && (mask & ~(SELECT_READ | SELECT_WRITE)) == 0);
+    assert(element && (mask & ~(SELECT_READ | SELECT_WRITE | Element::SELECT_EDGE)) == 0);
     lock();
 
     bool remove_read = false, remove_write = false;
@@ -424,6 +481,51 @@ SelectSet::run_selects_kqueue(RouterThread *thread)
 }
 #endif /* HAVE_ALLOW_KQUEUE */
 
+#if HAVE_ALLOW_EPOLL
+void
+SelectSet::run_selects_epoll(RouterThread *thread)
+{
+    // Registration persists in the kernel, so unlike poll() there is no
+    // per-iteration copy or scan of _pollfds.
+    int epfd = _epoll;
+# if HAVE_MULTITHREAD
+    click_fence();
+    _select_lock.release();
+# endif
+
+    // Decide how long to wait.
+    int timeout;
+    Timestamp t;
+    int delay_type = thread->timer_set().next_timer_delay(thread->active(), t);
+    if (delay_type == 0)
+	timeout = 0;
+    else if (delay_type > 0)
+	timeout = (t.sec() >= INT_MAX / 1000 ? INT_MAX - 1000 : t.msecval());
+    else
+	timeout = -1;
+    thread->set_thread_state_for_blocking(delay_type);
+
+    struct epoll_event ev[256];
+    int n = epoll_wait(epfd, &ev[0], 256, timeout);
+    int was_errno = errno;
+
+    if (post_select(thread, true))
+	return;
+
+    thread->set_thread_state(RouterThread::S_RUNSELECT);
+    if (n < 0 && was_errno != EINTR)
+	perror("epoll_wait");
+    else if (n > 0)
+	for (struct epoll_event *p = &ev[0]; p < &ev[n]; ++p) {
+	    // call_selected() checks _selinfo, so events for fds removed by
+	    // an earlier selected() in this batch are ignored
+	    int mask = (p->events & ~EPOLLOUT ? Element::SELECT_READ : 0)
+		+ (p->events & ~EPOLLIN ? Element::SELECT_WRITE : 0);
+	    call_selected(p->data.fd, mask);
+	}
+}
+#endif /* HAVE_ALLOW_EPOLL */
+
 #if HAVE_ALLOW_POLL
 void
 SelectSet::run_selects_poll(RouterThread *thread)
@@ -577,6 +679,12 @@ SelectSet::run_selects(RouterThread *thread)
 	    break;
 	}
 #endif
+#if HAVE_ALLOW_EPOLL
+	if (_epoll >= 0) {
+	    run_selects_epoll(thread);
+	    break;
+	}
+#endif
 #if HAVE_ALLOW_POLL
 	run_selects_poll(thread);
 #else
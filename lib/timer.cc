@@ -163,7 +163,10 @@ CLICK_DECLS
 
  The Click core stores timers in a heap, so most timer operations (including
  scheduling and unscheduling) take @e O(log @e n) time and Click can handle
- very large numbers of timers.
+ very large numbers of timers.  A RouterThread's TimerSet can instead keep
+ timers in a hierarchical timing wheel (see TimerSet::set_timer_wheel()),
+ which makes scheduling and unscheduling O(1) for timers more than a
+ millisecond in the future.
 
  Timers generally run in increasing order by expiration time.  That is, if
  timer @a a's expiry() is less than timer @a b's expiry(), then @a a will
@@ -267,6 +270,12 @@ Timer::schedule_at_steady(const Timestamp &when)
     _expiry_s = when ? when : Timestamp::epsilon();
     ts.check_timer_expiry(this);
 
+    // timers beyond the current tick go to the timing wheel, if any
+    if (ts._wheel_slots && ts.wheel_schedule(this)) {
+	ts.unlock_timers();
+	return;
+    }
+
     // manipulate list; this is essentially a "decrease-key" operation
     // any reschedule removes a timer from the runchunk (XXX -- even backwards
     // reschedulings)
@@ -313,7 +322,9 @@ Timer::unschedule()
 	ts._timer_heap.pop_back();
 	if (old_schedpos1 == 1)
 	    ts.set_timer_expiry();
-    } else if (_schedpos1 < 0)
+    } else if (TimerSet::wheel_scheduled(_schedpos1))
+	ts.wheel_remove(this);
+    else if (_schedpos1 < 0)
 	ts._timer_runchunk[-_schedpos1 - 1] = 0;
     _schedpos1 = 0;
     ts.unlock_timers();
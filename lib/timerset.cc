@@ -23,6 +23,7 @@
 #include <click/task.hh>
 #include <click/routerthread.hh>
 #include <click/heap.hh>
+#include <click/integers.hh>
 #include <click/master.hh>
 CLICK_DECLS
 
@@ -48,6 +49,13 @@ TimerSet::TimerSet()
 #endif
     _timer_check = Timestamp::now_steady();
     _timer_check_reports = 0;
+    _wheel_slots = 0;
+    _wheel_count = 0;
+}
+
+TimerSet::~TimerSet()
+{
+    delete[] _wheel_slots;
 }
 
 void
@@ -66,6 +74,16 @@ TimerSet::kill_router(Router *router)
 	    t->_schedpos1 = 0;
 	}
     }
+    if (_wheel_slots)
+	for (int slot = 0; slot < wheel_nslots; ++slot)
+	    for (int i = _wheel_slots[slot].size(); i > 0; ) {
+		--i;
+		Timer *t = _wheel_slots[slot][i];
+		if (t->router() == router) {
+		    wheel_remove(t);
+		    t->_owner = 0;
+		}
+	    }
     set_timer_expiry();
     unlock_timers();
 }
@@ -78,6 +96,246 @@ TimerSet::set_max_timer_stride(unsigned timer_stride)
 	_timer_stride = _max_timer_stride;
 }
 
+/** @brief Select the timing wheel or the plain heap for this TimerSet.
+ *
+ * With the wheel, scheduling a timer more than one millisecond tick in the
+ * future costs O(1) instead of O(log @e n): the timer waits in a hashed
+ * hierarchical timing wheel (256 one-millisecond slots, then three levels
+ * of 64 slots, about 18.6 hours in all) and moves to the heap once its tick
+ * comes up.  Timers still fire in expiry order within each tick, and the
+ * thread sleeps until the start of the next nonempty tick, so precision
+ * matches the heap.  Disabling the wheel moves its timers to the heap.
+ *
+ * next_timer() is only approximate with the wheel: when no timer is due
+ * within the current tick, it returns some timer from the first nonempty
+ * wheel slot, which need not be the earliest one.
+ *
+ * The userlevel driver enables the wheel on every thread given the
+ * --timer-wheel option. */
+void
+TimerSet::set_timer_wheel(bool wheel)
+{
+    lock_timers();
+    if (wheel && !_wheel_slots) {
+	_wheel_slots = new Vector<Timer *>[wheel_nslots];
+	memset(_wheel_bits, 0, sizeof(_wheel_bits));
+	_wheel_count = 0;
+	_wheel_now = Timestamp::now_steady().msecval();
+	_wheel_expiry = Timestamp();
+    } else if (!wheel && _wheel_slots) {
+	for (int slot = 0; slot < wheel_nslots; ++slot)
+	    for (Timer **tp = _wheel_slots[slot].begin();
+		 tp != _wheel_slots[slot].end(); ++tp)
+		heap_insert(*tp);
+	delete[] _wheel_slots;
+	_wheel_slots = 0;
+	_wheel_count = 0;
+	_wheel_expiry = Timestamp();
+	set_timer_expiry();
+    }
+    unlock_timers();
+}
+
+inline void
+TimerSet::heap_insert(Timer *t)
+{
+    t->_schedpos1 = _timer_heap.size() + 1;
+    _timer_heap.push_back(heap_element(t));
+    push_heap<4>(_timer_heap.begin(), _timer_heap.end(),
+		 heap_less(), heap_place());
+}
+
+// Level 0 has 1 << wheel_bits0 slots of one tick each.  Level L > 0 has
+// 1 << wheel_bits slots of 1 << wheel_shift(L) ticks each; its slots are
+// cascaded into lower levels when _wheel_now reaches their first tick.
+static inline int
+wheel_shift(int level)
+{
+    return level ? 8 + 6 * (level - 1) : 0;
+}
+
+static inline int
+wheel_base(int level)
+{
+    return level ? 256 + 64 * (level - 1) : 0;
+}
+
+static inline int
+wheel_size(int level)
+{
+    return level ? 64 : 256;
+}
+
+void
+TimerSet::wheel_insert(Timer *t, Timestamp::value_type tick)
+{
+    Timestamp::value_type delta = tick - _wheel_now;
+    int slot, level = 0;
+    while (level < wheel_levels
+	   && delta >= ((Timestamp::value_type) 1 << wheel_shift(level + 1)))
+	++level;
+    Timestamp::value_type due;
+    if (level < wheel_levels) {
+	int shift = wheel_shift(level);
+	slot = wheel_base(level) + ((tick >> shift) & (wheel_size(level) - 1));
+	due = (tick >> shift) << shift;
+	_wheel_bits[slot / 32] |= 1U << (slot % 32);
+    } else {
+	int shift = wheel_shift(wheel_levels);
+	slot = wheel_overflow;
+	due = ((_wheel_now >> shift) + 1) << shift;
+    }
+
+    Vector<Timer *> &v = _wheel_slots[slot];
+    t->_schedpos1 = wheel_schedpos1 - slot;
+    t->_wheelpos = v.size();
+    v.push_back(t);
+    if (!_wheel_count++ || due < _wheel_due) {
+	_wheel_due = due;
+	_wheel_expiry = Timestamp::make_msec(due);
+    }
+}
+
+void
+TimerSet::wheel_remove(Timer *t)
+{
+    int slot = wheel_schedpos1 - t->_schedpos1;
+    Vector<Timer *> &v = _wheel_slots[slot];
+    Timer *last = v.back();
+    v[t->_wheelpos] = last;
+    last->_wheelpos = t->_wheelpos;
+    v.pop_back();
+    if (v.empty() && slot != wheel_overflow)
+	_wheel_bits[slot / 32] &= ~(1U << (slot % 32));
+    --_wheel_count;
+    t->_schedpos1 = 0;
+}
+
+inline void
+TimerSet::wheel_place(Timer *t)
+{
+    Timestamp::value_type tick = t->_expiry_s.msecval();
+    if (tick <= _wheel_now)
+	heap_insert(t);
+    else
+	wheel_insert(t, tick);
+}
+
+bool
+TimerSet::wheel_schedule(Timer *t)
+{
+    Timestamp::value_type tick = t->_expiry_s.msecval();
+    if (tick <= _wheel_now) {
+	// due this tick: belongs in the heap
+	if (wheel_scheduled(t->_schedpos1))
+	    wheel_remove(t);
+	return false;
+    }
+
+    int old_schedpos1 = t->_schedpos1;
+    if (old_schedpos1 > 0) {
+	remove_heap<4>(_timer_heap.begin(), _timer_heap.end(),
+		       _timer_heap.begin() + old_schedpos1 - 1,
+		       heap_less(), heap_place());
+	_timer_heap.pop_back();
+    } else if (wheel_scheduled(old_schedpos1))
+	wheel_remove(t);
+    else if (old_schedpos1 < 0)
+	_timer_runchunk[-old_schedpos1 - 1] = 0;
+    wheel_insert(t, tick);
+
+    Timestamp old_expiry = _timer_expiry;
+    if (old_schedpos1 == 1 || !old_expiry || _wheel_expiry < old_expiry)
+	set_timer_expiry();
+    if (!old_expiry || _timer_expiry < old_expiry)
+	t->_thread->wake();
+    return true;
+}
+
+void
+TimerSet::wheel_cascade(int slot)
+{
+    if (_wheel_slots[slot].empty())
+	return;
+    _wheel_cascade.swap(_wheel_slots[slot]);
+    if (slot != wheel_overflow)
+	_wheel_bits[slot / 32] &= ~(1U << (slot % 32));
+    _wheel_count -= _wheel_cascade.size();
+    for (Timer **tp = _wheel_cascade.begin(); tp != _wheel_cascade.end(); ++tp)
+	wheel_place(*tp);
+    _wheel_cascade.clear();
+}
+
+static int
+wheel_find(const uint32_t *bits, int nbits, int start)
+{
+    // first set bit at or after start, wrapping around; -1 if none
+    int nwords = nbits / 32, w = start / 32;
+    uint32_t x = bits[w] & (~0U << (start % 32));
+    for (int i = 0; i <= nwords; ++i) {
+	if (x)
+	    return w * 32 + ffs_lsb(x) - 1;
+	w = (w + 1 == nwords ? 0 : w + 1);
+	x = bits[w];
+    }
+    return -1;
+}
+
+Timestamp::value_type
+TimerSet::wheel_next_due(int *slotp) const
+{
+    Timestamp::value_type due = 0;
+    int slot = -1;
+    for (int level = 0; level < wheel_levels; ++level) {
+	int shift = wheel_shift(level), mask = wheel_size(level) - 1;
+	Timestamp::value_type cur = _wheel_now >> shift;
+	int i = wheel_find(_wheel_bits + wheel_base(level) / 32,
+			   wheel_size(level), (cur + 1) & mask);
+	if (i >= 0) {
+	    Timestamp::value_type d = ((i - cur - 1) & mask) + 1;
+	    Timestamp::value_type x = (cur + d) << shift;
+	    if (slot < 0 || x < due)
+		due = x, slot = wheel_base(level) + i;
+	}
+    }
+    if (_wheel_slots[wheel_overflow].size()) {
+	int shift = wheel_shift(wheel_levels);
+	Timestamp::value_type x = ((_wheel_now >> shift) + 1) << shift;
+	if (slot < 0 || x < due)
+	    due = x, slot = wheel_overflow;
+    }
+    if (slotp)
+	*slotp = slot;
+    return due;
+}
+
+void
+TimerSet::wheel_advance(Timestamp::value_type target)
+{
+    // Jumping _wheel_now forward is safe as long as no nonempty tick is
+    // skipped, since every slot maps to the same tick relative to any
+    // earlier _wheel_now.
+    while (_wheel_count && _wheel_due <= target) {
+	Timestamp::value_type tick = _wheel_now = _wheel_due;
+	for (int level = wheel_levels; level > 0; --level) {
+	    int shift = wheel_shift(level);
+	    if (tick & (((Timestamp::value_type) 1 << shift) - 1))
+		continue;
+	    if (level == wheel_levels)
+		wheel_cascade(wheel_overflow);
+	    else
+		wheel_cascade(wheel_base(level) + ((tick >> shift) & (wheel_size(level) - 1)));
+	}
+	wheel_cascade(tick & (wheel_size(0) - 1));
+	if (_wheel_count)
+	    _wheel_due = wheel_next_due(0);
+    }
+    if (target > _wheel_now)
+	_wheel_now = target;
+    _wheel_expiry = _wheel_count ? Timestamp::make_msec(_wheel_due) : Timestamp();
+    set_timer_expiry();
+}
+
 void
 TimerSet::check_timer_expiry(Timer *t)
 {
@@ -115,7 +373,8 @@ TimerSet::run_timers(RouterThread *thread, Master *master)
 {
     if (!_timer_lock.attempt())
 	return;
-    if (!master->paused() && _timer_heap.size() > 0 && !thread->stop_flag()) {
+    if (!master->paused() && (_timer_heap.size() > 0 || _wheel_count)
+	&& !thread->stop_flag()) {
 	thread->set_thread_state(RouterThread::S_RUNTIMER);
 #if CLICK_LINUXMODULE
 	_timer_task = current;
@@ -123,9 +382,11 @@ TimerSet::run_timers(RouterThread *thread, Master *master)
 	_timer_processor = click_current_processor();
 #endif
 	_timer_check = Timestamp::now_steady();
+	if (_wheel_slots)
+	    wheel_advance(_timer_check.msecval());
 	heap_element *th = _timer_heap.begin();
 
-	if (th->expiry_s <= _timer_check) {
+	if (_timer_heap.size() > 0 && th->expiry_s <= _timer_check) {
 	    // potentially adjust timer stride
 	    Timestamp adj_expiry = th->expiry_s + Timer::adjustment();
 	    if (adj_expiry <= _timer_check) {